@@ -0,0 +1,81 @@
+// Per-call cost of log_once_per on the suppressed path, before and after
+// the per-call-site slot. Build and run with `make bench-log`.
+//
+// "legacy" is the previous implementation (string key + mutex + map),
+// copied here so the comparison keeps working.
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "log.h"
+
+namespace legacy {
+static std::unordered_map<std::string, std::chrono::steady_clock::time_point>
+    timestamps;
+static std::mutex mutex;
+
+template <typename... Args>
+inline void log_once_per_keyed(std::chrono::milliseconds interval,
+                               LogLevel level, const char *file, int line,
+                               const char *format, Args &&...args) {
+  if (static_cast<int>(level) < static_cast<int>(AFTER_HOURS_LOG_LEVEL))
+    return;
+  std::string key = fmt::format("{}:{}:{}", file, line, format);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = timestamps.find(key);
+    if (it == timestamps.end() || (now - it->second) >= interval) {
+      log_me(level, file, line, format, std::forward<Args>(args)...);
+      timestamps[key] = now;
+    }
+  }
+}
+} // namespace legacy
+
+using Clock = std::chrono::steady_clock;
+constexpr int kCalls = 2'000'000;
+
+template <typename Fn> double ns_per_call(int threads, Fn &&fn) {
+  std::vector<std::thread> pool;
+  const auto start = Clock::now();
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([&fn, t] {
+      for (int i = 0; i < kCalls; i++)
+        fn(t, i);
+    });
+  }
+  for (std::thread &th : pool)
+    th.join();
+  const double ns =
+      (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+          Clock::now() - start)
+          .count();
+  // Wall time per call on each thread; with fewer cores than threads this
+  // includes time slicing, so compare before/after rather than absolutes
+  return ns / kCalls;
+}
+
+int main() {
+  // Long enough that only the first call in each run logs
+  const std::chrono::milliseconds interval(60'000);
+
+  for (int threads : {1, 4}) {
+    const double before = ns_per_call(threads, [&](int t, int i) {
+      legacy::log_once_per_keyed(interval, LogLevel::LOG_WARN, __FILE__,
+                                 __LINE__, "legacy thread {} call {}", t, i);
+    });
+    const double after = ns_per_call(threads, [&](int t, int i) {
+      log_once_per(interval, LogLevel::LOG_WARN, "slot thread {} call {}", t,
+                   i);
+    });
+    fmt::print("log_once_per suppressed, {} thread(s): legacy {:.1f} ns/call, "
+               "slot {:.1f} ns/call ({:.1f}x)\n",
+               threads, before, after, before / after);
+  }
+  return 0;
+}
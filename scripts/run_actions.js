@@ -6,6 +6,17 @@
    - Must include exactly one .toml file (input playback)
    - Must include exactly one .json file (expected UI tree subset)
 
+ Pass --batch to play every scenario inside a single ui.exe process
+ (ui.exe --actions-dir=actions). ui.exe matches each scenario's expected
+ .json against the live tree itself (same rules as matchNode below) and the
+ runner only reads the verdicts from its results file. Add --fork to have
+ ui.exe play shared step prefixes once and fork per branch (--fork-prefixes).
+
+ Pass --jobs=N (or just --jobs for one per core) to run scenarios in N
+ parallel ui.exe processes. Each scenario dumps to its own binary .uitree
+ file under output/actions/, and scenarios are scheduled longest-first using the
+ durations recorded by previous runs in output/action_timings.json.
+
  Validation rules:
  - Expected JSON is a subset matcher by name: every expected node must exist
    in the actual tree at the corresponding position in the tree (by name),
@@ -15,12 +26,17 @@
 
 const fs = require('fs');
 const path = require('path');
-const { spawnSync } = require('child_process');
+const os = require('os');
+const { spawn, spawnSync } = require('child_process');
+const { readUiTree } = require('./ui_tree');
 
 const REPO_ROOT = path.resolve(__dirname, '..');
 const ACTIONS_DIR = path.join(REPO_ROOT, 'actions');
 const UI_EXE = path.join(REPO_ROOT, 'ui.exe');
 const ACTUAL_JSON = path.join(REPO_ROOT, 'ui_tree.json');
+const BATCH_RESULTS_JSON = path.join(REPO_ROOT, 'action_results.json');
+const PARALLEL_OUT_DIR = path.join(REPO_ROOT, 'output', 'actions');
+const TIMINGS_JSON = path.join(REPO_ROOT, 'output', 'action_timings.json');
 
 const TOLERANCE = parseFloat(process.env.UI_POS_TOL || '0.5');
 
@@ -73,7 +89,7 @@ function matchNode(expected, actual, errs, pathStr) {
   return true;
 }
 
-function runScenario(dir) {
+function loadScenario(dir) {
   const files = fs.readdirSync(dir);
   const tomls = files.filter(f => f.toLowerCase().endsWith('.toml'));
   // Ignore meta.json when selecting the expected JSON file
@@ -95,8 +111,21 @@ function runScenario(dir) {
     }
   }
 
+  return { tomlPath, expectedPath, meta };
+}
+
+function checkScenario(scenario, actual) {
+  const expected = readJson(scenario.expectedPath);
+  const errs = [];
+  const ok = matchNode(expected.root, actual.root, errs, 'root');
+  return { ok, errs, meta: scenario.meta };
+}
+
+function runScenario(dir) {
+  const scenario = loadScenario(dir);
+
   // Run ui.exe with actions in headless mode
-  const run = spawnSync(UI_EXE, [ `--actions=${tomlPath}`, `--no-window` ], { cwd: REPO_ROOT, stdio: 'inherit' });
+  const run = spawnSync(UI_EXE, [ `--actions=${scenario.tomlPath}`, `--headless` ], { cwd: REPO_ROOT, stdio: 'inherit' });
   if (run.status !== 0) {
     throw new Error(`ui.exe exited with code ${run.status} for scenario '${path.basename(dir)}'`);
   }
@@ -104,11 +133,120 @@ function runScenario(dir) {
     throw new Error(`ui_tree.json not produced for scenario '${path.basename(dir)}'`);
   }
 
-  const expected = readJson(expectedPath);
-  const actual = readJson(ACTUAL_JSON);
-  const errs = [];
-  const ok = matchNode(expected.root, actual.root, errs, 'root');
-  return { ok, errs, meta };
+  return checkScenario(scenario, readUiTree(ACTUAL_JSON));
+}
+
+// Runs all scenarios in one ui.exe process; returns a runner per scenario dir
+// that validates the tree recorded for it in the batch results file.
+function runBatch(scenarios, filter, fork) {
+  if (fs.existsSync(BATCH_RESULTS_JSON)) fs.unlinkSync(BATCH_RESULTS_JSON);
+  const args = [ `--actions-dir=${ACTIONS_DIR}`, `--results=${BATCH_RESULTS_JSON}`, `--headless` ];
+  if (filter) args.push(`--filter=${filter}`);
+  if (fork) args.push('--fork-prefixes');
+  const run = spawnSync(UI_EXE, args, { cwd: REPO_ROOT, stdio: 'inherit' });
+  if (run.status !== 0 || !fs.existsSync(BATCH_RESULTS_JSON)) {
+    throw new Error(`ui.exe batch run failed with code ${run.status}`);
+  }
+  const byName = new Map();
+  for (const r of readJson(BATCH_RESULTS_JSON).scenarios) byName.set(r.name, r);
+
+  return (dir) => {
+    const name = path.basename(dir);
+    const scenario = loadScenario(dir);
+    const result = byName.get(name);
+    if (!result) throw new Error(`no batch result for scenario '${name}'`);
+    if (result.error) throw new Error(result.error);
+    // ui.exe already matched the live tree against the expected .json
+    if (result.ok !== undefined) {
+      return { ok: result.ok, errs: result.errors.map(e => e.message), kinds: result.errors.map(e => e.kind), meta: scenario.meta };
+    }
+    return checkScenario(scenario, result.tree);
+  };
+}
+
+function readTimings() {
+  try {
+    return readJson(TIMINGS_JSON);
+  } catch (e) {
+    return {};
+  }
+}
+
+function writeTimings(timings) {
+  fs.mkdirSync(path.dirname(TIMINGS_JSON), { recursive: true });
+  fs.writeFileSync(TIMINGS_JSON, JSON.stringify(timings, null, 2), 'utf8');
+}
+
+function spawnScenario(scenario, dumpPath) {
+  return new Promise((resolve) => {
+    const start = Date.now();
+    const child = spawn(UI_EXE, [ `--actions=${scenario.tomlPath}`, `--dump=${dumpPath}`, `--headless` ], { cwd: REPO_ROOT });
+    let output = '';
+    child.stdout.on('data', d => { output += d; });
+    child.stderr.on('data', d => { output += d; });
+    child.on('error', e => resolve({ status: -1, output: e.message, ms: Date.now() - start }));
+    child.on('close', status => resolve({ status, output, ms: Date.now() - start }));
+  });
+}
+
+// Work queue over `jobs` concurrent ui.exe processes. Scenarios with the
+// longest recorded duration start first (unknown ones are treated as longest)
+// so a slow scenario never ends up alone at the tail of the run.
+async function runParallel(scenarios, jobs) {
+  fs.mkdirSync(PARALLEL_OUT_DIR, { recursive: true });
+  const timings = readTimings();
+  const queue = scenarios.slice().sort((a, b) =>
+    (timings[path.basename(b)] ?? Infinity) - (timings[path.basename(a)] ?? Infinity));
+  const outcomes = new Map();
+
+  const worker = async () => {
+    for (let dir = queue.shift(); dir !== undefined; dir = queue.shift()) {
+      const name = path.basename(dir);
+      const dumpPath = path.join(PARALLEL_OUT_DIR, `${name}.uitree`);
+      try {
+        const scenario = loadScenario(dir);
+        if (fs.existsSync(dumpPath)) fs.unlinkSync(dumpPath);
+        const run = await spawnScenario(scenario, dumpPath);
+        timings[name] = run.ms;
+        if (run.status !== 0) {
+          process.stdout.write(run.output);
+          throw new Error(`ui.exe exited with code ${run.status} for scenario '${name}'`);
+        }
+        if (!fs.existsSync(dumpPath)) {
+          throw new Error(`${path.relative(REPO_ROOT, dumpPath)} not produced for scenario '${name}'`);
+        }
+        outcomes.set(dir, { res: checkScenario(scenario, readUiTree(dumpPath)) });
+      } catch (e) {
+        outcomes.set(dir, { error: e });
+      }
+    }
+  };
+  await Promise.all(Array.from({ length: Math.min(jobs, scenarios.length) }, worker));
+  writeTimings(timings);
+  // Report in the usual directory order regardless of completion order
+  return scenarios.map(dir => ({ dir, ...outcomes.get(dir) }));
+}
+
+// A scenario whose meta.json has "expect_fail": "<kind>" passes only when it
+// fails. Batch results carry error kinds, so there it must fail with that
+// kind; a single ui.exe run only has its exit code to go by.
+function applyExpectFail(outcome) {
+  let meta;
+  try {
+    meta = loadScenario(outcome.dir).meta;
+  } catch (e) {
+    return outcome;
+  }
+  const kind = meta.expect_fail;
+  if (!kind) return outcome;
+  const { dir, res } = outcome;
+  if (res && res.ok) {
+    return { dir, res: { ok: false, errs: [`expected to fail with ${kind}, but passed`], meta } };
+  }
+  if (res && res.kinds && !res.kinds.includes(kind)) {
+    return { dir, res: { ok: false, errs: [`expected to fail with ${kind}, got:`, ...res.errs], meta } };
+  }
+  return { dir, res: { ok: true, errs: [], meta } };
 }
 
 function findScenarios(rootDir, filter) {
@@ -119,8 +257,21 @@ function findScenarios(rootDir, filter) {
     .filter(dir => !filter || dir.includes(filter));
 }
 
-function main() {
-  const filter = process.argv[2] || '';
+function parseArgs(argv) {
+  const opts = { filter: '', batch: false, fork: false, jobs: 1 };
+  for (const arg of argv) {
+    if (arg === '--batch') opts.batch = true;
+    else if (arg === '--fork') opts.batch = opts.fork = true;
+    else if (arg === '--jobs') opts.jobs = os.cpus().length;
+    else if (arg.startsWith('--jobs=')) opts.jobs = Math.max(1, parseInt(arg.slice('--jobs='.length), 10) || 1);
+    else if (!arg.startsWith('--')) opts.filter = arg;
+    else console.warn(`[WARN] Unknown option '${arg}'`);
+  }
+  return opts;
+}
+
+async function main() {
+  const { filter, batch, fork, jobs } = parseArgs(process.argv.slice(2));
   if (!fs.existsSync(UI_EXE)) {
     console.error(`Missing binary at ${UI_EXE}. Build first (make).`);
     process.exit(2);
@@ -131,14 +282,46 @@ function main() {
     process.exit(2);
   }
 
+  let outcomes;
+  if (batch) {
+    if (jobs > 1) console.warn('[WARN] --jobs is ignored with --batch');
+    let run;
+    try {
+      run = runBatch(scenarios, filter, fork);
+    } catch (e) {
+      console.error(`[ERROR] ${e.message}`);
+      process.exit(1);
+    }
+    outcomes = scenarios.map(dir => {
+      try {
+        return { dir, res: run(dir) };
+      } catch (e) {
+        return { dir, error: e };
+      }
+    });
+  } else if (jobs > 1) {
+    outcomes = await runParallel(scenarios, jobs);
+  } else {
+    outcomes = scenarios.map(dir => {
+      try {
+        return { dir, res: runScenario(dir) };
+      } catch (e) {
+        return { dir, error: e };
+      }
+    });
+  }
+
+  outcomes = outcomes.map(applyExpectFail);
+
   let passed = 0;
   let failed = 0;
   const results = [];
   const tags = [];
-  for (const dir of scenarios) {
+  for (const { dir, res, error } of outcomes) {
     const name = path.basename(dir);
     try {
-      const { ok, errs, meta } = runScenario(dir);
+      if (error) throw error;
+      const { ok, errs, meta } = res;
       if (ok) {
         console.log(`[PASS] ${name}`);
         passed++;
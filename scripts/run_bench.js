@@ -0,0 +1,390 @@
+#!/usr/bin/env node
+/*
+ Autolayout scaling benchmark (make bench)
+
+ Plays generated stress trees (see src/ui_demo/examples/stress_tree.cpp)
+ across shapes and node counts and records per-frame timings from ui.exe's
+ frame profiler (--profile-summary).
+
+ - Shapes set the fanout of the generated tree:
+     flat (one row of N), wide (16), balanced (4), deep (a chain of N)
+ - Sizes default to 10, 100, 1k, 10k and 100k nodes. Chains are capped at
+   --max-depth nodes (default 1000) since layout recurses per level.
+ - Every frame presses WidgetNext so input processing scales with the number
+   of focusable buttons (every 4th leaf is a button).
+
+ Options:
+   --sizes=10,100,...      node counts
+   --shapes=flat,deep,...  subset of shapes
+   --sizing=mixed          pixels | percent | children | mixed
+   --frames=120            measured frames per case
+   --headless              no window (skips render timings; default uses a
+                           hidden window via --no-window)
+   --out=<file>            results (default output/bench_results.json)
+   --baseline=<file>       compare frame p50 against an earlier results file
+   --threshold=1.25        ratio over baseline that counts as a regression
+
+ Results: { meta, cases: [{ name, shape, fanout, nodes, sizing, frames,
+   spans: { <span>: { samples, p50_ms, p95_ms, p99_ms, max_ms } } }] }
+ Span names are the profiler's: frame, update, input, DemoRouter (tree
+ build), ui_after (autolayout), render, ui_render, present.
+
+ --suite=list plays the windowed list screen (src/ui_demo/virtual_list.h)
+ instead, scrolling one row per frame over --rows row counts (default 100,
+ 10k and 1M) with --columns cells per row. Each case also records entity
+ counts from --alloc-stats; cases gain rows, columns, entities_max and
+ created (entities made during the measured frames). The run fails when the
+ entity count differs between row counts, since the list should only ever
+ hold the rows in view (keep --rows above a screenful, 25 rows).
+
+ --suite=alloc calibrates scenario allocation budgets. Every scenario under
+ actions/ with a p95_allocs_per_frame, or with "alloc_budget": true in its
+ meta.json, is played headless, the way the action tests run it, with
+ --alloc-stats, and its measured p95 allocations per frame (first frame left
+ out, like the budget check) is printed next to the budget. The suggested
+ budget is the p95 times --margin (default 1.25). --update writes the
+ suggestions back into the TOMLs, adding the key where there is none yet. Counts depend on the
+ build and the platform, so calibrate with the build that runs the tests.
+ Scenarios longer than 4096 frames are measured over the last 4096 only.
+ Results go to output/alloc_budgets.json unless --out is given.
+*/
+
+const fs = require('fs');
+const path = require('path');
+const { spawnSync } = require('child_process');
+
+const REPO_ROOT = path.resolve(__dirname, '..');
+const UI_EXE = path.join(REPO_ROOT, 'ui.exe');
+const BENCH_DIR = path.join(REPO_ROOT, 'output', 'bench');
+const DEFAULT_OUT = path.join(REPO_ROOT, 'output', 'bench_results.json');
+const ALLOC_OUT = path.join(REPO_ROOT, 'output', 'alloc_budgets.json');
+const ACTIONS_DIR = path.join(REPO_ROOT, 'actions');
+const BUDGET_KEY = /^p95_allocs_per_frame\s*=\s*(\d+)/m;
+
+const SHAPES = {
+  flat: nodes => Math.max(1, nodes - 1),
+  wide: () => 16,
+  balanced: () => 4,
+  deep: () => 1,
+};
+
+// Spans shown in the console table; everything is kept in the results file
+const REPORT_SPANS = ['frame', 'DemoRouter', 'ui_after', 'input', 'ui_render'];
+
+function parseArgs(argv) {
+  const opts = {
+    sizes: [10, 100, 1000, 10000, 100000],
+    shapes: Object.keys(SHAPES),
+    sizing: 'mixed',
+    frames: 120,
+    maxDepth: 1000,
+    headless: false,
+    out: '',
+    baseline: '',
+    threshold: 1.25,
+    suite: 'layout',
+    rows: [100, 10000, 1000000],
+    columns: 1,
+    margin: 1.25,
+    update: false,
+  };
+  const list = v => v.split(',').filter(Boolean);
+  for (const arg of argv) {
+    const [key, value] = arg.split(/=(.*)/s);
+    if (key === '--sizes') opts.sizes = list(value).map(Number);
+    else if (key === '--shapes') opts.shapes = list(value);
+    else if (key === '--sizing') opts.sizing = value;
+    else if (key === '--frames') opts.frames = Math.max(1, parseInt(value, 10) || 1);
+    else if (key === '--max-depth') opts.maxDepth = parseInt(value, 10);
+    else if (key === '--headless') opts.headless = true;
+    else if (key === '--out') opts.out = path.resolve(value);
+    else if (key === '--baseline') opts.baseline = path.resolve(value);
+    else if (key === '--threshold') opts.threshold = parseFloat(value);
+    else if (key === '--suite') opts.suite = value;
+    else if (key === '--rows') opts.rows = list(value).map(Number);
+    else if (key === '--columns') opts.columns = Math.max(1, parseInt(value, 10) || 1);
+    else if (key === '--margin') opts.margin = Math.max(1, parseFloat(value) || 1);
+    else if (key === '--update') opts.update = true;
+    else console.warn(`[WARN] Unknown option '${arg}'`);
+  }
+  if (!['layout', 'list', 'alloc'].includes(opts.suite)) {
+    console.error(`Unknown suite '${opts.suite}' (expected layout, list, alloc)`);
+    process.exit(2);
+  }
+  if (!opts.out) opts.out = opts.suite === 'alloc' ? ALLOC_OUT : DEFAULT_OUT;
+  for (const s of opts.shapes) {
+    if (!SHAPES[s]) {
+      console.error(`Unknown shape '${s}' (expected ${Object.keys(SHAPES).join(', ')})`);
+      process.exit(2);
+    }
+  }
+  return opts;
+}
+
+function writeCaseToml(file, c, frames) {
+  const lines = [
+    'autoquit = true',
+    'dump_path = ""',
+    '',
+    '[stress]',
+    `nodes = ${c.nodes}`,
+    `fanout = ${c.fanout}`,
+    `sizing = "${c.sizing}"`,
+    'button_every = 4',
+    '',
+  ];
+  lines.push('[[step]]', 'pressed = ["WidgetNext"]', `repeat = ${frames}`, '');
+  fs.writeFileSync(file, lines.join('\n'));
+}
+
+function writeListCaseToml(file, c, frames) {
+  const lines = [
+    'autoquit = true',
+    'dump_path = ""',
+    '',
+    '[virtual_list]',
+    `rows = ${c.rows}`,
+    `columns = ${c.columns}`,
+    '',
+    // Rows only appear once the list has been laid out
+    '[[step]]',
+    `wait_for = "${c.columns > 1 ? 'virtual_list_cell' : 'virtual_list_row'}"`,
+    'timeout_frames = 100',
+    '',
+    '[[step]]',
+    'pressed = ["ValueDown"]',
+    `repeat = ${frames}`,
+    '',
+  ];
+  fs.writeFileSync(file, lines.join('\n'));
+}
+
+// Entity counts over the measured (last `frames`) frames of --alloc-stats
+function entityCounts(file, frames) {
+  const { per_frame: perFrame } = JSON.parse(fs.readFileSync(file, 'utf8'));
+  const measured = perFrame.slice(-frames);
+  return {
+    entities_max: Math.max(0, ...measured.map(f => f[3])),
+    created: measured.reduce((sum, f) => sum + f[4], 0),
+  };
+}
+
+function runCase(c, opts) {
+  const toml = path.join(BENCH_DIR, `${c.name}.toml`);
+  const summary = path.join(BENCH_DIR, `${c.name}.json`);
+  const trace = path.join(BENCH_DIR, `${c.name}.trace.json`);
+  const allocs = path.join(BENCH_DIR, `${c.name}.allocs.json`);
+  const list = opts.suite === 'list';
+  if (list) writeListCaseToml(toml, c, opts.frames);
+  else writeCaseToml(toml, c, opts.frames);
+  fs.rmSync(summary, { force: true });
+
+  const args = [
+    `--actions=${toml}`,
+    '--fast-forward',
+    opts.headless ? '--headless' : '--no-window',
+    `--profile=${trace}`,
+    `--profile-summary=${summary}`,
+  ];
+  if (list) args.push(`--alloc-stats=${allocs}`);
+  const started = Date.now();
+  const run = spawnSync(UI_EXE, args, { cwd: REPO_ROOT, stdio: ['ignore', 'ignore', 'inherit'] });
+  const wallMs = Date.now() - started;
+  if (run.status !== 0 || !fs.existsSync(summary)) {
+    throw new Error(`ui.exe exited with code ${run.status}`);
+  }
+  const { frames, spans } = JSON.parse(fs.readFileSync(summary, 'utf8'));
+  const entities = list ? entityCounts(allocs, opts.frames) : {};
+  return { ...c, frames, wall_ms: wallMs, spans, ...entities };
+}
+
+// Same rank as AllocStats::pct
+function percentile(sorted, p) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p / 100))];
+}
+
+// Scenarios with a p95_allocs_per_frame, plus those whose meta.json asks
+// for one ("alloc_budget": true) but haven't been measured yet
+function budgetScenarios() {
+  const out = [];
+  for (const dir of fs.readdirSync(ACTIONS_DIR).sort()) {
+    const toml = path.join(ACTIONS_DIR, dir, `${dir}.toml`);
+    if (!fs.existsSync(toml)) continue;
+    const m = fs.readFileSync(toml, 'utf8').match(BUDGET_KEY);
+    const metaPath = path.join(ACTIONS_DIR, dir, 'meta.json');
+    const meta = fs.existsSync(metaPath) ? JSON.parse(fs.readFileSync(metaPath, 'utf8')) : {};
+    if (m || meta.alloc_budget === true) {
+      out.push({ name: dir, toml, budget: m ? parseInt(m[1], 10) : null });
+    }
+  }
+  return out;
+}
+
+// Replaces the budget, or adds it after the last top-level key
+function writeBudget(toml, budget) {
+  const text = fs.readFileSync(toml, 'utf8');
+  const line = `p95_allocs_per_frame = ${budget}`;
+  if (BUDGET_KEY.test(text)) {
+    fs.writeFileSync(toml, text.replace(BUDGET_KEY, line));
+    return;
+  }
+  const lines = text.split('\n');
+  let at = 0;
+  for (let i = 0; i < lines.length && !lines[i].startsWith('['); i++) {
+    if (/^\w+\s*=/.test(lines[i])) at = i + 1;
+  }
+  // Below the comment that usually follows, which explains the budget
+  while (at < lines.length && lines[at].startsWith('#')) at++;
+  lines.splice(at, 0, line);
+  fs.writeFileSync(toml, lines.join('\n'));
+}
+
+// Plays one budget scenario and measures its allocations per frame. The
+// exit code is ignored: a scenario over its current budget still measures.
+function runAllocCase(c, opts) {
+  const allocs = path.join(BENCH_DIR, `${c.name}.allocs.json`);
+  const dump = path.join(BENCH_DIR, `${c.name}.tree.json`);
+  fs.rmSync(allocs, { force: true });
+  spawnSync(UI_EXE, [
+    `--actions=${c.toml}`,
+    `--dump=${dump}`,
+    '--headless',
+    '--fast-forward',
+    `--alloc-stats=${allocs}`,
+  ], { cwd: REPO_ROOT, stdio: ['ignore', 'ignore', 'inherit'] });
+  if (!fs.existsSync(allocs)) throw new Error('ui.exe wrote no --alloc-stats');
+  const { per_frame: perFrame } = JSON.parse(fs.readFileSync(allocs, 'utf8'));
+  const sorted = perFrame.slice(1).map(f => f[0]).sort((a, b) => a - b);
+  if (sorted.length === 0) throw new Error('no frames measured');
+  const p95 = percentile(sorted, 95);
+  return {
+    ...c,
+    frames: sorted.length,
+    p50: percentile(sorted, 50),
+    p95,
+    max: sorted[sorted.length - 1],
+    suggested: Math.ceil(p95 * opts.margin),
+  };
+}
+
+function runAllocSuite(opts) {
+  const cases = budgetScenarios();
+  console.log(`allocations per frame, suggested budget = p95 x ${opts.margin}`);
+  console.log(['scenario'.padEnd(28), ...['frames', 'p50', 'p95', 'max', 'budget', 'suggested'].map(h => h.padStart(10))].join(''));
+  const results = { meta: { date: new Date().toISOString(), margin: opts.margin }, cases: [] };
+  let errors = 0;
+  for (const c of cases) {
+    try {
+      const res = runAllocCase(c, opts);
+      results.cases.push(res);
+      console.log([c.name.padEnd(28), ...[res.frames, res.p50, res.p95, res.max, res.budget ?? '-', res.suggested].map(v => String(v).padStart(10))].join(''));
+      if (opts.update && res.suggested !== c.budget) {
+        writeBudget(c.toml, res.suggested);
+        console.log(`  updated ${path.relative(REPO_ROOT, c.toml)}: ${c.budget ?? 'none'} -> ${res.suggested}`);
+      }
+    } catch (e) {
+      console.log(`${c.name.padEnd(28)} [ERROR] ${e.message}`);
+      results.cases.push({ ...c, error: e.message });
+      errors++;
+    }
+  }
+  fs.mkdirSync(path.dirname(opts.out), { recursive: true });
+  fs.writeFileSync(opts.out, JSON.stringify(results, null, 2));
+  console.log(`\nWrote ${opts.out}`);
+  process.exit(errors > 0 ? 1 : 0);
+}
+
+function fmtMs(span) {
+  return (span ? span.p50_ms.toFixed(3) : '-').padStart(10);
+}
+
+function compareBaseline(results, opts) {
+  const baseline = JSON.parse(fs.readFileSync(opts.baseline, 'utf8'));
+  const before = new Map(baseline.cases.map(c => [c.name, c]));
+  const regressions = [];
+  for (const c of results.cases) {
+    const prev = before.get(c.name);
+    if (!prev?.spans?.frame || !c.spans?.frame) continue;
+    const ratio = c.spans.frame.p50_ms / prev.spans.frame.p50_ms;
+    if (ratio > opts.threshold) {
+      regressions.push(`${c.name}: frame p50 ${prev.spans.frame.p50_ms.toFixed(3)}ms -> ${c.spans.frame.p50_ms.toFixed(3)}ms (${ratio.toFixed(2)}x)`);
+    }
+  }
+  return regressions;
+}
+
+function main() {
+  const opts = parseArgs(process.argv.slice(2));
+  if (!fs.existsSync(UI_EXE)) {
+    console.error(`Missing binary at ${UI_EXE}. Build first (make).`);
+    process.exit(2);
+  }
+  fs.mkdirSync(BENCH_DIR, { recursive: true });
+  if (opts.suite === 'alloc') runAllocSuite(opts);
+
+  const cases = [];
+  for (const rows of opts.suite === 'list' ? opts.rows : []) {
+    cases.push({ name: `list_${rows}x${opts.columns}`, rows, columns: opts.columns });
+  }
+  for (const shape of opts.suite === 'layout' ? opts.shapes : []) {
+    for (const nodes of opts.sizes) {
+      if (shape === 'deep' && nodes > opts.maxDepth) continue;
+      const fanout = SHAPES[shape](nodes);
+      cases.push({ name: `${shape}_${nodes}_${opts.sizing}`, shape, fanout, nodes, sizing: opts.sizing });
+    }
+  }
+
+  const listSuite = opts.suite === 'list';
+  const header = ['case'.padEnd(28), ...REPORT_SPANS.map(s => s.padStart(11)),
+    ...(listSuite ? ['entities'.padStart(10), 'created'.padStart(9)] : [])].join('');
+  console.log(`p50 ms over ${opts.frames} frames${opts.headless ? ' (headless, no render)' : ''}`);
+  console.log(header);
+  const results = {
+    meta: {
+      date: new Date().toISOString(),
+      commit: spawnSync('git', ['rev-parse', '--short', 'HEAD'], { cwd: REPO_ROOT, encoding: 'utf8' }).stdout.trim(),
+      headless: opts.headless,
+      frames: opts.frames,
+      suite: opts.suite,
+    },
+    cases: [],
+  };
+  let errors = 0;
+  for (const c of cases) {
+    try {
+      const res = runCase(c, opts);
+      results.cases.push(res);
+      const counts = listSuite
+        ? [String(res.entities_max).padStart(10), String(res.created).padStart(9)]
+        : [];
+      console.log([c.name.padEnd(28), ...REPORT_SPANS.map(s => ' ' + fmtMs(res.spans[s])), ...counts].join(''));
+    } catch (e) {
+      console.log(`${c.name.padEnd(28)} [ERROR] ${e.message}`);
+      results.cases.push({ ...c, error: e.message });
+      errors++;
+    }
+  }
+
+  fs.mkdirSync(path.dirname(opts.out), { recursive: true });
+  fs.writeFileSync(opts.out, JSON.stringify(results, null, 2));
+  console.log(`\nWrote ${opts.out}`);
+
+  if (listSuite) {
+    const counts = new Set(results.cases.filter(c => !c.error).map(c => c.entities_max));
+    if (counts.size > 1) {
+      console.log(`[REGRESSION] entity count depends on row count: ${[...counts].join(', ')}`);
+      errors++;
+    }
+  }
+
+  if (opts.baseline) {
+    const regressions = compareBaseline(results, opts);
+    regressions.forEach(r => console.log(`[REGRESSION] ${r}`));
+    if (regressions.length > 0) process.exit(1);
+  }
+  process.exit(errors > 0 ? 1 : 0);
+}
+
+if (require.main === module) {
+  main();
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env node
+/*
+ Rebuild UI trees from a --trace=<file> recording (see src/ui_demo/trace.h).
+
+ Usage:
+   node scripts/ui_trace.js <trace> [frame]   tree at `frame` (default: last)
+   node scripts/ui_trace.js <trace> --list    per-frame change counts
+
+ The tree for a frame is printed in the same shape as ui_tree.json, so it can
+ be fed to the same tooling as a regular dump.
+*/
+
+const fs = require('fs');
+const { ByteReader } = require('./ui_tree');
+
+const MAGIC = 'AHTR';
+const VERSION = 1;
+
+// Calls onFrame(frameIndex, ops, nodes, rootId) after each complete frame;
+// returning true from it stops the replay early.
+function replayTrace(buf, onFrame) {
+  if (buf.toString('latin1', 0, MAGIC.length) !== MAGIC) {
+    throw new Error('not a UI trace file');
+  }
+  const r = new ByteReader(buf, MAGIC.length);
+  const version = r.u8();
+  if (version !== VERSION) throw new Error(`unsupported trace version ${version}`);
+
+  const nodes = new Map();
+  let rootId = -1;
+  while (!r.done()) {
+    const start = r.pos;
+    try {
+      if (String.fromCharCode(r.u8()) !== 'F') throw new Error(`bad frame tag at ${start}`);
+      const frame = r.varint();
+      const frameRoot = r.zigzag();
+      const ops = { added: 0, moved: 0, children: 0, removed: 0 };
+      const pending = [];
+      for (;;) {
+        const tag = String.fromCharCode(r.u8());
+        if (tag === 'E') break;
+        const id = r.zigzag();
+        if (tag === 'N') {
+          const name = r.name();
+          const rect = r.rect();
+          pending.push(() => nodes.set(id, { name, rect, children: nodes.get(id)?.children ?? [] }));
+          ops.added++;
+        } else if (tag === 'M') {
+          const rect = r.rect();
+          pending.push(() => { nodes.get(id).rect = rect; });
+          ops.moved++;
+        } else if (tag === 'C') {
+          const n = r.varint();
+          const children = [];
+          for (let i = 0; i < n; i++) children.push(r.zigzag());
+          pending.push(() => { nodes.get(id).children = children; });
+          ops.children++;
+        } else if (tag === 'R') {
+          pending.push(() => nodes.delete(id));
+          ops.removed++;
+        } else {
+          throw new Error(`bad op tag '${tag}' at ${r.pos - 1}`);
+        }
+      }
+      // Only apply frames that were fully written
+      pending.forEach(apply => apply());
+      rootId = frameRoot;
+      if (onFrame(frame, ops, nodes, rootId)) return;
+    } catch (e) {
+      if (e instanceof RangeError) return; // truncated tail
+      throw e;
+    }
+  }
+}
+
+function buildTree(nodes, id) {
+  const n = nodes.get(id);
+  if (!n) return { id, name: 'missing', rect: { x: 0, y: 0, w: 0, h: 0 }, children: [] };
+  return { id, name: n.name, rect: n.rect, children: n.children.map(c => buildTree(nodes, c)) };
+}
+
+function main() {
+  const [file, arg] = process.argv.slice(2);
+  if (!file) {
+    console.error('usage: node scripts/ui_trace.js <trace> [frame|--list]');
+    process.exit(2);
+  }
+  const buf = fs.readFileSync(file);
+
+  if (arg === '--list') {
+    replayTrace(buf, (frame, ops, nodes) => {
+      console.log(`frame ${frame}: +${ops.added} -${ops.removed} moved ${ops.moved} relinked ${ops.children} (${nodes.size} nodes)`);
+    });
+    return;
+  }
+
+  const target = arg === undefined ? Infinity : parseInt(arg, 10);
+  let tree = null;
+  let at = null;
+  replayTrace(buf, (frame, ops, nodes, rootId) => {
+    if (frame > target) return true;
+    tree = { root: buildTree(nodes, rootId) };
+    at = frame;
+    return false;
+  });
+  if (!tree) {
+    console.error(`no recorded frame at or before ${arg}`);
+    process.exit(1);
+  }
+  // Frames without changes are not recorded; the tree is the one from `at`
+  process.stderr.write(`frame ${arg ?? at} (last change at frame ${at})\n`);
+  process.stdout.write(JSON.stringify(tree, null, 2) + '\n');
+}
+
+module.exports = { replayTrace, buildTree };
+
+if (require.main === module) {
+  main();
+}
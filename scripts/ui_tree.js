@@ -0,0 +1,114 @@
+#!/usr/bin/env node
+/*
+ Read a UI tree dump written by ui.exe (see src/ui_demo/dump.h).
+
+ Both encodings decode to the same shape:
+   { root: { id, name, rect: { x, y, w, h }, children: [...] } }
+
+ - JSON dumps (any extension) are parsed as-is
+ - Binary dumps (.uitree, magic "AHUT") are decoded here
+
+ As a tool it prints the decoded tree as pretty JSON:
+   node scripts/ui_tree.js ui_tree.uitree > ui_tree.json
+*/
+
+const fs = require('fs');
+
+const MAGIC = 'AHUT';
+const VERSION = 1;
+
+// Little endian reader for the primitives in src/ui_demo/dump.h
+class ByteReader {
+  constructor(buf, pos = 0) {
+    this.buf = buf;
+    this.pos = pos;
+    this.names = [];
+  }
+
+  done() {
+    return this.pos >= this.buf.length;
+  }
+
+  u8() {
+    return this.buf.readUInt8(this.pos++);
+  }
+
+  varint() {
+    let result = 0;
+    let mul = 1;
+    for (;;) {
+      const b = this.u8();
+      result += (b & 0x7f) * mul;
+      if ((b & 0x80) === 0) return result;
+      mul *= 128;
+    }
+  }
+
+  zigzag() {
+    const v = this.varint();
+    return v % 2 === 0 ? v / 2 : -(v + 1) / 2;
+  }
+
+  f32() {
+    const v = this.buf.readFloatLE(this.pos);
+    this.pos += 4;
+    return v;
+  }
+
+  rect() {
+    return { x: this.f32(), y: this.f32(), w: this.f32(), h: this.f32() };
+  }
+
+  // UITreeNameTable: 0 => new name inline, k => k-th name seen so far
+  name() {
+    const ref = this.varint();
+    if (ref !== 0) return this.names[ref - 1];
+    const len = this.varint();
+    const name = this.buf.toString('utf8', this.pos, this.pos + len);
+    this.pos += len;
+    this.names.push(name);
+    return name;
+  }
+}
+
+function decodeBinary(buf) {
+  const r = new ByteReader(buf, MAGIC.length);
+  const version = r.u8();
+  if (version !== VERSION) {
+    throw new Error(`unsupported .uitree version ${version}`);
+  }
+
+  const readNode = () => {
+    const id = r.zigzag();
+    const name = r.name();
+    const rect = r.rect();
+    const count = r.varint();
+    const children = new Array(count);
+    for (let i = 0; i < count; i++) children[i] = readNode();
+    return { id, name, rect, children };
+  };
+
+  return { root: readNode() };
+}
+
+function parseUiTree(buf) {
+  if (buf.length >= MAGIC.length && buf.toString('latin1', 0, MAGIC.length) === MAGIC) {
+    return decodeBinary(buf);
+  }
+  return JSON.parse(buf.toString('utf8'));
+}
+
+function readUiTree(file) {
+  return parseUiTree(fs.readFileSync(file));
+}
+
+module.exports = { readUiTree, parseUiTree, ByteReader };
+
+if (require.main === module) {
+  const file = process.argv[2];
+  if (!file) {
+    console.error('usage: node scripts/ui_tree.js <ui_tree.json|ui_tree.uitree>');
+    process.exit(2);
+  }
+  process.stdout.write(JSON.stringify(readUiTree(file), null, 2) + '\n');
+}
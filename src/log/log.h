@@ -2,14 +2,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <fstream>
 #include <functional>
 #include <iostream>
-#include <mutex>
+#include <limits>
 #include <string>
-#include <unordered_map>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -33,16 +33,48 @@ constexpr std::string_view color_red = "";
 constexpr std::string_view color_white = "";
 #endif
 
-// TODO log to file
-
 inline const std::string_view level_to_string(LogLevel level) {
   return magic_enum::enum_name(level);
 }
 
+// File sink and background writer, see async_log::start
+#include "log_async.h"
+
+// Formats the whole line once into a stack buffer and hands it to the async
+// backend; the frame thread never touches stdout
+inline void vlog_async(async_log::Logger &logger, LogLevel level,
+                       const char *file, int line, fmt::string_view format,
+                       fmt::format_args args) {
+  using async_log::kRecordBytes;
+  async_log::Record rec;
+  rec.level = level;
+  char *out = rec.text;
+  size_t room = kRecordBytes;
+  if (line != -1) {
+    const auto res = fmt::format_to_n(out, room, "{}: {}: {}: ", file, line,
+                                      level_to_string(level));
+    const size_t n = std::min(res.size, room);
+    out += n;
+    room -= n;
+  }
+  const auto res = fmt::vformat_to_n(out, room, format, args);
+  size_t len = (size_t)(out - rec.text) + std::min(res.size, room);
+  if (res.size > room) {
+    std::memcpy(rec.text + kRecordBytes - 3, "...", 3);
+    len = kRecordBytes;
+  }
+  rec.len = (uint16_t)len;
+  logger.push(rec);
+}
+
 inline void vlog(LogLevel level, const char *file, int line,
                  fmt::string_view format, fmt::format_args args) {
   if (level < AFTER_HOURS_LOG_LEVEL)
     return;
+  if (async_log::Logger *logger = async_log::instance()) {
+    vlog_async(*logger, level, file, line, format, args);
+    return;
+  }
   auto file_info =
       fmt::format("{}: {}: {}: ", file, line, level_to_string(level));
   if (line == -1) {
@@ -77,32 +109,49 @@ inline void log_me(LogLevel level, const char *file, int line,
   vlog(level, file, line, format, fmt::make_format_args(args));
 }
 
-// Thread-safe storage for log_once_per timing
-namespace {
-static std::unordered_map<std::string, std::chrono::steady_clock::time_point>
-    log_once_per_timestamps;
-static std::mutex log_once_per_mutex;
-} // namespace
-
-template <typename Level, typename... Args>
-inline void log_once_per(std::chrono::milliseconds interval, Level level,
-                         const char *file, int line, const char *format,
-                         Args &&...args) {
+// Deferred-format binary log, see binary_log::start
+#include "log_binary.h"
+
+inline bool log_level_enabled(LogLevel level) {
+  return static_cast<int>(level) >= static_cast<int>(AFTER_HOURS_LOG_LEVEL) ||
+         binary_log::wants(level);
+}
+
+// Entry point for the log_* macros. `site` returns the call site's LogSite
+// and is only called when a binary log is open.
+template <typename SiteFn, typename... Args>
+inline void log_me_at(LogLevel level, SiteFn &&site, const char *file,
+                      int line, const char *format, Args &&...args) {
+  if (binary_log::Writer *w = binary_log::instance();
+      w && level >= w->min_level) {
+    w->write(site(), format, args...);
+    // Warnings and errors still show up live
+    if (level < LogLevel::LOG_WARN)
+      return;
+  }
   if (static_cast<int>(level) < static_cast<int>(AFTER_HOURS_LOG_LEVEL))
     return;
-  // Create a unique key for this log message
-  std::string key = fmt::format("{}:{}:{}", file, line, format);
-  {
-    std::lock_guard<std::mutex> lock(log_once_per_mutex);
-    auto now = std::chrono::steady_clock::now();
-    auto it = log_once_per_timestamps.find(key);
-    if (it == log_once_per_timestamps.end() || (now - it->second) >= interval) {
-      // Log the message and update timestamp
-      log_me(static_cast<LogLevel>(level), file, line, format,
-             std::forward<Args>(args)...);
-      log_once_per_timestamps[key] = now;
-    }
-  }
+  log_me(level, file, line, format, std::forward<Args>(args)...);
 }
 
+// One per log_once_per call site (a function-local static made by the
+// macro), so the suppressed path is a clock read plus one relaxed load and
+// compare: no key string, no map, no lock. When several threads hit an open
+// window at once the CAS picks the single one that logs.
+struct LogOncePerSlot {
+  static constexpr int64_t kNever = std::numeric_limits<int64_t>::min();
+  std::atomic<int64_t> last_ns{kNever};
+
+  bool should_log(std::chrono::nanoseconds interval) {
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    int64_t last = last_ns.load(std::memory_order_relaxed);
+    if (last != kNever && now - last < interval.count())
+      return false;
+    return last_ns.compare_exchange_strong(last, now,
+                                           std::memory_order_relaxed);
+  }
+};
+
 #include "log_macros.h"
@@ -0,0 +1,342 @@
+#pragma once
+
+// Asynchronous log backend. Producers format a record on their own stack and
+// push it into a bounded lock-free MPSC ring (Vyukov's bounded queue with one
+// consumer); a background thread drains it in batches to stdout and/or a
+// rotating file. When the ring is full the record is dropped and counted, so
+// a warning storm can never stall the frame thread. Until start() is called
+// (and after stop()) vlog prints synchronously as before.
+//
+// Included from log.h after the color constants it defaults to.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "log_level.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <unistd.h>
+#define AFTER_HOURS_ASYNC_LOG_SIGNALS
+#endif
+
+namespace async_log {
+
+struct Config {
+  bool to_stdout = true;
+  std::string file_path;                       // empty = no file sink
+  size_t max_file_bytes = 8 * 1024 * 1024;     // rotate once past this
+  int max_files = 3;                           // log, log.1, ... log.N-1
+  // Wrap stdout lines only; the file sink is always plain (see log.h)
+  std::string_view color_warn = ::color_red;
+  std::string_view color_info = ::color_white;
+  std::string_view color_reset = ::color_reset;
+};
+
+// Longer messages are cut off and end in "..."
+constexpr size_t kRecordBytes = 512;
+constexpr size_t kRingSlots = 4096; // power of two
+
+struct Record {
+  LogLevel level;
+  uint16_t len;
+  char text[kRecordBytes];
+};
+
+class Logger {
+public:
+  explicit Logger(Config cfg) : cfg_(std::move(cfg)) {
+    slots_ = std::make_unique<Slot[]>(kRingSlots);
+    for (size_t i = 0; i < kRingSlots; i++)
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    if (!cfg_.file_path.empty())
+      open_file();
+    thread_ = std::thread([this] { run(); });
+  }
+
+  ~Logger() {
+    running_.store(false, std::memory_order_release);
+    wake();
+    if (thread_.joinable())
+      thread_.join();
+    drain(); // anything pushed after the thread's last pass
+    if (file_)
+      std::fclose(file_);
+  }
+
+  // Lock-free; never blocks. Returns false if the record was dropped.
+  bool push(const Record &rec) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;) {
+      slot = &slots_[pos & (kRingSlots - 1)];
+      const size_t seq = slot->seq.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    std::memcpy(&slot->rec, &rec, offsetof(Record, text) + rec.len);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    wake();
+    return true;
+  }
+
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // Best effort from a signal handler: write out whatever is queued with
+  // plain write(2). If the consumer thread is mid-batch, give it a moment to
+  // finish (it may be the thread that crashed, so don't wait forever).
+  void flush_from_signal() {
+    bool expected = false;
+    for (int spins = 0;
+         !draining_.compare_exchange_strong(expected, true); spins++) {
+      if (spins == 200)
+        return;
+      expected = false;
+#ifdef AFTER_HOURS_ASYNC_LOG_SIGNALS
+      ::usleep(1000);
+#endif
+    }
+    Record rec;
+    while (pop(rec)) {
+      if (cfg_.to_stdout)
+        write_fd(1, rec.text, rec.len, "\n");
+      if (file_)
+        write_fd(fileno(file_), rec.text, rec.len, "\n");
+    }
+    draining_.store(false);
+  }
+
+private:
+  struct Slot {
+    std::atomic<size_t> seq;
+    Record rec;
+  };
+
+  Config cfg_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) size_t head_ = 0; // consumer only
+  alignas(64) std::atomic<uint32_t> wake_seq_{0};
+  std::atomic<uint64_t> dropped_{0};
+  uint64_t reported_dropped_ = 0;
+  std::atomic<bool> running_{true};
+  std::atomic<bool> draining_{false};
+  std::thread thread_;
+  FILE *file_ = nullptr;
+  size_t file_bytes_ = 0;
+
+  void wake() {
+    wake_seq_.fetch_add(1, std::memory_order_release);
+    wake_seq_.notify_one();
+  }
+
+  bool pop(Record &out) {
+    Slot &slot = slots_[head_ & (kRingSlots - 1)];
+    const size_t seq = slot.seq.load(std::memory_order_acquire);
+    if ((intptr_t)seq - (intptr_t)(head_ + 1) < 0)
+      return false;
+    std::memcpy(&out, &slot.rec, offsetof(Record, text) + slot.rec.len);
+    slot.seq.store(head_ + kRingSlots, std::memory_order_release);
+    head_++;
+    return true;
+  }
+
+  static void write_fd(int fd, const char *data, size_t len,
+                       const char *suffix) {
+#ifdef AFTER_HOURS_ASYNC_LOG_SIGNALS
+    (void)!::write(fd, data, len);
+    (void)!::write(fd, suffix, std::strlen(suffix));
+#else
+    (void)fd;
+    std::fwrite(data, 1, len, stdout);
+    std::fputs(suffix, stdout);
+#endif
+  }
+
+  void run() {
+    while (running_.load(std::memory_order_acquire)) {
+      const uint32_t seen = wake_seq_.load(std::memory_order_acquire);
+      drain();
+      wake_seq_.wait(seen, std::memory_order_acquire);
+    }
+  }
+
+  // One write per sink per batch
+  void drain() {
+    bool expected = false;
+    if (!draining_.compare_exchange_strong(expected, true))
+      return;
+    fmt::memory_buffer out;
+    fmt::memory_buffer plain;
+    Record rec;
+    const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_dropped_) {
+      const std::string note =
+          fmt::format("log: dropped {} records (ring full)",
+                      dropped - reported_dropped_);
+      reported_dropped_ = dropped;
+      append(out, plain, LogLevel::LOG_WARN, note.data(), note.size());
+    }
+    while (pop(rec)) {
+      append(out, plain, rec.level, rec.text, rec.len);
+      if (file_ && file_bytes_ + plain.size() >= cfg_.max_file_bytes)
+        write_file(plain);
+    }
+    if (cfg_.to_stdout && out.size() > 0) {
+      std::fwrite(out.data(), 1, out.size(), stdout);
+      std::fflush(stdout);
+    }
+    if (file_ && plain.size() > 0)
+      write_file(plain);
+    draining_.store(false);
+  }
+
+  void write_file(fmt::memory_buffer &plain) {
+    std::fwrite(plain.data(), 1, plain.size(), file_);
+    std::fflush(file_);
+    file_bytes_ += plain.size();
+    plain.clear();
+    if (file_bytes_ >= cfg_.max_file_bytes)
+      rotate();
+  }
+
+  void append(fmt::memory_buffer &out, fmt::memory_buffer &plain,
+              LogLevel level, const char *text, size_t len) {
+    if (cfg_.to_stdout) {
+      const std::string_view color =
+          level >= LogLevel::LOG_WARN ? cfg_.color_warn : cfg_.color_info;
+      out.append(color.data(), color.data() + color.size());
+      out.append(text, text + len);
+      out.append(cfg_.color_reset.data(),
+                 cfg_.color_reset.data() + cfg_.color_reset.size());
+      out.push_back('\n');
+    }
+    if (file_) {
+      plain.append(text, text + len);
+      plain.push_back('\n');
+    }
+  }
+
+  void open_file() {
+    file_ = std::fopen(cfg_.file_path.c_str(), "a");
+    if (!file_) {
+      std::fprintf(stderr, "log: failed opening %s\n", cfg_.file_path.c_str());
+      return;
+    }
+    std::fseek(file_, 0, SEEK_END);
+    file_bytes_ = (size_t)std::max(0L, std::ftell(file_));
+  }
+
+  // log -> log.1 -> ... -> log.(max_files - 1), oldest is deleted
+  void rotate() {
+    std::fclose(file_);
+    file_ = nullptr;
+    const std::string &base = cfg_.file_path;
+    for (int i = cfg_.max_files - 1; i >= 1; i--) {
+      const std::string from =
+          i == 1 ? base : fmt::format("{}.{}", base, i - 1);
+      std::rename(from.c_str(), fmt::format("{}.{}", base, i).c_str());
+    }
+    if (cfg_.max_files <= 1)
+      std::remove(base.c_str());
+    open_file();
+  }
+};
+
+inline std::atomic<Logger *> &instance_ptr() {
+  static std::atomic<Logger *> ptr{nullptr};
+  return ptr;
+}
+
+inline Logger *instance() {
+  return instance_ptr().load(std::memory_order_acquire);
+}
+
+#ifdef AFTER_HOURS_ASYNC_LOG_SIGNALS
+// Handlers that were installed before start(), e.g. backward::SignalHandling
+inline std::array<struct sigaction, NSIG> &previous_handlers() {
+  static std::array<struct sigaction, NSIG> handlers{};
+  return handlers;
+}
+
+inline void crash_handler(int signo, siginfo_t *info, void *ctx) {
+  if (Logger *logger = instance())
+    logger->flush_from_signal();
+  // Hand over to whoever was there first so stack traces still print
+  const struct sigaction &prev = previous_handlers()[(size_t)signo];
+  if (prev.sa_flags & SA_SIGINFO) {
+    if (prev.sa_sigaction) {
+      prev.sa_sigaction(signo, info, ctx);
+      return;
+    }
+  } else if (prev.sa_handler != SIG_DFL && prev.sa_handler != SIG_IGN) {
+    prev.sa_handler(signo);
+    return;
+  }
+  ::signal(signo, SIG_DFL);
+  ::raise(signo);
+}
+
+// Chains in front of the existing handler for each fatal signal
+inline void install_crash_flush(const std::vector<int> &signals) {
+  for (int signo : signals) {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    if (sigaction(signo, nullptr, &previous_handlers()[(size_t)signo]) != 0)
+      continue;
+    action.sa_sigaction = &crash_handler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER | SA_RESETHAND;
+    sigfillset(&action.sa_mask);
+    sigaction(signo, &action, nullptr);
+  }
+}
+#endif
+
+inline void start(Config cfg, const std::vector<int> &crash_signals = {}) {
+  if (instance())
+    return;
+  instance_ptr().store(new Logger(std::move(cfg)), std::memory_order_release);
+#ifdef AFTER_HOURS_ASYNC_LOG_SIGNALS
+  install_crash_flush(crash_signals);
+#else
+  (void)crash_signals;
+#endif
+}
+
+// Flushes everything queued and goes back to synchronous printing. Other
+// threads must be done logging by then.
+inline void stop() {
+  Logger *logger = instance_ptr().exchange(nullptr);
+  delete logger;
+}
+
+// Keeps the async backend running for a scope (normally main)
+struct Session {
+  Session(Config cfg, const std::vector<int> &crash_signals) {
+    start(std::move(cfg), crash_signals);
+  }
+  ~Session() { stop(); }
+  Session(const Session &) = delete;
+  Session &operator=(const Session &) = delete;
+};
+
+} // namespace async_log
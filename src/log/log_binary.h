@@ -0,0 +1,299 @@
+#pragma once
+
+// Deferred-format binary log (--log-binary=<file>). A log_* call site owns a
+// constant-initialized LogSite (made by the macro); while a binary log is
+// open, a call writes only the site id, a timestamp and the raw argument
+// bytes into a per-thread buffer. Nothing is formatted on the calling
+// thread. tools/log_decode.cpp turns the file back into text.
+//
+// File layout (varints are LEB128, zigzag for signed values):
+//   "AHBL" u8 version
+//   'S' varint site, varint level, varint line, str file, str format
+//       written once per site, before any record that uses it
+//   'C' varint thread, varint n, n bytes of records from that thread
+// Records inside a chunk:
+//   'L' varint site, varint dt_ns, varint argc, argc x (u8 tag, payload)
+//   'T' varint level, varint dt_ns, str text      preformatted fallback
+// dt_ns is relative to the thread's previous record (the first one to the
+// time the log was opened). Argument tags:
+//   'i' zigzag  'u' varint  'd' f64  'b' u8  'c' u8  'p' u64  's' str
+// where str is varint length + bytes. Types fmt can format but that have no
+// tag here are formatted to 's' at the call site.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "log_level.h"
+
+struct LogSite {
+  const char *file;
+  int line;
+  LogLevel level;
+  // 0 until first written to the current binary log
+  std::atomic<uint32_t> id{0};
+  std::atomic<uint32_t> log_generation{0};
+  const char *format = nullptr;
+
+  constexpr LogSite(const char *f, int l, LogLevel lvl)
+      : file(f), line(l), level(lvl) {}
+};
+
+namespace binary_log {
+
+constexpr char kMagic[4] = {'A', 'H', 'B', 'L'};
+constexpr uint8_t kVersion = 1;
+constexpr size_t kFlushBytes = 32 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+inline void put_varint(std::vector<uint8_t> &out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+inline void put_zigzag(std::vector<uint8_t> &out, int64_t v) {
+  put_varint(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+inline void put_bytes(std::vector<uint8_t> &out, const void *data,
+                      size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  out.insert(out.end(), p, p + len);
+}
+
+inline void put_str(std::vector<uint8_t> &out, std::string_view s) {
+  put_varint(out, s.size());
+  put_bytes(out, s.data(), s.size());
+}
+
+template <typename T> inline void put_arg(std::vector<uint8_t> &out, T &&v) {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::is_same_v<U, bool>) {
+    out.push_back('b');
+    out.push_back(v ? 1 : 0);
+  } else if constexpr (std::is_same_v<U, char>) {
+    out.push_back('c');
+    out.push_back((uint8_t)v);
+  } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+    out.push_back('i');
+    put_zigzag(out, (int64_t)v);
+  } else if constexpr (std::is_integral_v<U>) {
+    out.push_back('u');
+    put_varint(out, (uint64_t)v);
+  } else if constexpr (std::is_floating_point_v<U>) {
+    const double d = (double)v;
+    out.push_back('d');
+    put_bytes(out, &d, sizeof(d));
+  } else if constexpr (std::is_convertible_v<const U &, const char *>) {
+    const char *str = v;
+    out.push_back('s');
+    put_str(out, str ? str : "(null)");
+  } else if constexpr (std::is_convertible_v<const U &, std::string_view>) {
+    out.push_back('s');
+    put_str(out, std::string_view(v));
+  } else if constexpr (std::is_pointer_v<U>) {
+    const uint64_t p = (uint64_t)(uintptr_t)v;
+    out.push_back('p');
+    put_bytes(out, &p, sizeof(p));
+  } else {
+    out.push_back('s');
+    put_str(out, fmt::format("{}", v));
+  }
+}
+
+class Writer;
+
+struct ThreadBuffer {
+  Writer *owner = nullptr;
+  uint32_t generation = 0;
+  uint32_t thread_index = 0;
+  int64_t last_ns = 0;
+  std::vector<uint8_t> bytes;
+
+  ~ThreadBuffer();
+};
+
+inline ThreadBuffer &thread_buffer() {
+  thread_local ThreadBuffer buffer;
+  return buffer;
+}
+
+class Writer {
+public:
+  const LogLevel min_level;
+  const uint32_t generation;
+
+  Writer(const std::string &path, LogLevel level, uint32_t gen)
+      : min_level(level), generation(gen) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_)
+      return;
+    std::fwrite(kMagic, 1, sizeof(kMagic), file_);
+    std::fputc(kVersion, file_);
+  }
+
+  ~Writer() {
+    flush(thread_buffer());
+    if (file_)
+      std::fclose(file_);
+  }
+
+  bool ok() const { return file_ != nullptr; }
+
+  template <typename... Args>
+  void write(LogSite &site, const char *format, Args &&...args) {
+    ThreadBuffer &buf = attach(thread_buffer());
+    const int64_t now = now_ns();
+    // The site is keyed by its first format; a call site that passes a
+    // different (runtime) format string gets a preformatted record instead
+    const uint32_t id = site_id(site, format);
+    if (id == 0 || site.format != format) {
+      buf.bytes.push_back('T');
+      put_varint(buf.bytes, (uint64_t)site.level);
+      put_varint(buf.bytes, (uint64_t)(now - buf.last_ns));
+      put_str(buf.bytes,
+              fmt::vformat(format, fmt::make_format_args(args...)));
+    } else {
+      buf.bytes.push_back('L');
+      put_varint(buf.bytes, id);
+      put_varint(buf.bytes, (uint64_t)(now - buf.last_ns));
+      put_varint(buf.bytes, sizeof...(Args));
+      (put_arg(buf.bytes, args), ...);
+    }
+    buf.last_ns = now;
+    if (buf.bytes.size() >= kFlushBytes)
+      flush(buf);
+  }
+
+  // Moves this thread's records into the file
+  void flush(ThreadBuffer &buf) {
+    if (buf.owner != this || buf.generation != generation ||
+        buf.bytes.empty())
+      return;
+    std::vector<uint8_t> header;
+    header.push_back('C');
+    put_varint(header, buf.thread_index);
+    put_varint(header, buf.bytes.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+      std::fwrite(header.data(), 1, header.size(), file_);
+      std::fwrite(buf.bytes.data(), 1, buf.bytes.size(), file_);
+    }
+    buf.bytes.clear();
+  }
+
+private:
+  FILE *file_ = nullptr;
+  std::mutex mutex_;
+  uint32_t next_site_ = 1;
+  std::atomic<uint32_t> next_thread_{0};
+  const Clock::time_point start_ = Clock::now();
+
+  int64_t now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                start_)
+        .count();
+  }
+
+  ThreadBuffer &attach(ThreadBuffer &buf) {
+    if (buf.owner != this || buf.generation != generation) {
+      buf.owner = this;
+      buf.generation = generation;
+      buf.thread_index = next_thread_.fetch_add(1);
+      buf.last_ns = 0;
+      buf.bytes.clear();
+      buf.bytes.reserve(kFlushBytes + 1024);
+    }
+    return buf;
+  }
+
+  // Registers the site in this log on first use; after that it is one
+  // acquire load and a compare
+  uint32_t site_id(LogSite &site, const char *format) {
+    if (site.log_generation.load(std::memory_order_acquire) == generation)
+      return site.id.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (site.log_generation.load(std::memory_order_relaxed) == generation)
+      return site.id.load(std::memory_order_relaxed);
+    const uint32_t id = next_site_++;
+    site.format = format;
+    if (file_) {
+      std::vector<uint8_t> rec;
+      rec.push_back('S');
+      put_varint(rec, id);
+      put_varint(rec, (uint64_t)site.level);
+      put_varint(rec, (uint64_t)site.line);
+      put_str(rec, site.file ? site.file : "");
+      put_str(rec, format ? format : "");
+      std::fwrite(rec.data(), 1, rec.size(), file_);
+    }
+    site.id.store(id, std::memory_order_relaxed);
+    site.log_generation.store(generation, std::memory_order_release);
+    return id;
+  }
+};
+
+inline std::atomic<Writer *> &instance_ptr() {
+  static std::atomic<Writer *> ptr{nullptr};
+  return ptr;
+}
+
+inline Writer *instance() {
+  return instance_ptr().load(std::memory_order_acquire);
+}
+
+// Whether a log_* call at `level` has to run at all
+inline bool wants(LogLevel level) {
+  Writer *w = instance();
+  return w && level >= w->min_level;
+}
+
+inline ThreadBuffer::~ThreadBuffer() {
+  if (owner && owner == instance())
+    owner->flush(*this);
+}
+
+// Other threads must be done logging before stop(); records they have not
+// flushed yet are lost
+inline bool start(const std::string &path, LogLevel min_level) {
+  static uint32_t generation = 0;
+  if (instance())
+    return true;
+  Writer *w = new Writer(path, min_level, ++generation);
+  if (!w->ok()) {
+    delete w;
+    return false;
+  }
+  instance_ptr().store(w, std::memory_order_release);
+  return true;
+}
+
+inline void stop() {
+  Writer *w = instance_ptr().exchange(nullptr);
+  delete w;
+}
+
+// Keeps a binary log open for a scope (normally main)
+struct Session {
+  bool ok = false;
+  Session(const std::string &path, LogLevel min_level)
+      : ok(start(path, min_level)) {}
+  ~Session() { stop(); }
+  Session(const Session &) = delete;
+  Session &operator=(const Session &) = delete;
+};
+
+} // namespace binary_log
@@ -1,22 +1,21 @@
 #pragma once
 
-#define log_trace(...)                                                         \
-  if (static_cast<int>(LogLevel::LOG_TRACE) >=                                 \
-      static_cast<int>(AFTER_HOURS_LOG_LEVEL))                                 \
-  log_me(LogLevel::LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
+// Each call site gets a constant-initialized LogSite for the binary log
+#define log_at(level, ...)                                                     \
+  if (log_level_enabled(level))                                                \
+  log_me_at(                                                                   \
+      level,                                                                   \
+      []() -> LogSite & {                                                      \
+        static LogSite log_site{__FILE__, __LINE__, level};                    \
+        return log_site;                                                       \
+      },                                                                       \
+      __FILE__, __LINE__, __VA_ARGS__)
 
-#define log_info(...)                                                          \
-  if (static_cast<int>(LogLevel::LOG_INFO) >=                                  \
-      static_cast<int>(AFTER_HOURS_LOG_LEVEL))                                 \
-  log_me(LogLevel::LOG_INFO, __FILE__, __LINE__, __VA_ARGS__)
-#define log_warn(...)                                                          \
-  if (static_cast<int>(LogLevel::LOG_WARN) >=                                  \
-      static_cast<int>(AFTER_HOURS_LOG_LEVEL))                                 \
-  log_me(LogLevel::LOG_WARN, __FILE__, __LINE__, __VA_ARGS__)
+#define log_trace(...) log_at(LogLevel::LOG_TRACE, __VA_ARGS__)
+#define log_info(...) log_at(LogLevel::LOG_INFO, __VA_ARGS__)
+#define log_warn(...) log_at(LogLevel::LOG_WARN, __VA_ARGS__)
 #define log_error(...)                                                         \
-  if (static_cast<int>(LogLevel::LOG_ERROR) >=                                 \
-      static_cast<int>(AFTER_HOURS_LOG_LEVEL))                                 \
-    log_me(LogLevel::LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__);              \
+  log_at(LogLevel::LOG_ERROR, __VA_ARGS__);                                    \
   assert(false)
 
 #define log_clean(level, ...)                                                  \
@@ -35,5 +34,12 @@
       log_me(level, __FILE__, __LINE__, __VA_ARGS__);                          \
   }
 
+// Logs at most once per `interval` from this call site
 #define log_once_per(interval, level, ...)                                     \
-  log_once_per(interval, level, __FILE__, __LINE__, __VA_ARGS__)
+  do {                                                                         \
+    if (static_cast<int>(level) >= static_cast<int>(AFTER_HOURS_LOG_LEVEL)) {  \
+      static LogOncePerSlot log_once_per_slot;                                 \
+      if (log_once_per_slot.should_log(interval))                              \
+        log_me(static_cast<LogLevel>(level), __FILE__, __LINE__, __VA_ARGS__); \
+    }                                                                          \
+  } while (0)
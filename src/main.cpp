@@ -14,11 +14,26 @@ backward::SignalHandling sh;
 #include "log.h"
 #include "magic_enum/magic_enum.hpp"
 #include "toml.hpp"
+#include "ui_demo/action_cache.h"
+#include "ui_demo/alloc_stats.h"
+#include "ui_demo/batch.h"
+#include "ui_demo/batch_fork.h"
 #include "ui_demo/dump.h"
+#include "ui_demo/expect.h"
 #include "ui_demo/input_mapping.h"
+#include "ui_demo/layout_stats.h"
+#include "ui_demo/null_render.h"
 #include "ui_demo/playback.h"
+#include "ui_demo/profiler.h"
+#include "ui_demo/recorder.h"
+#include "ui_demo/render_batch.h"
 #include "ui_demo/router.h"
+#include "ui_demo/sim_clock.h"
 #include "ui_demo/styling.h"
+#include "ui_demo/subtree_retention.h"
+#include "ui_demo/text_cache.h"
+#include "ui_demo/trace.h"
+#include "ui_demo/wait.h"
 
 // Workaround for missing log_once_per function - must be defined before
 // afterhours includes
@@ -61,6 +76,16 @@ template <typename T> int sgn(T val) { return (T(0) < val) - (val < T(0)); }
 
 struct EQ : public afterhours::EntityQuery<EQ> {};
 
+// --layout-stats: dirty node counts per frame, also shown under the FPS
+std::unique_ptr<LayoutStats> g_layout_stats;
+// --alloc-stats or a scenario's p95_allocs_per_frame: heap and entity churn
+std::unique_ptr<AllocStats> g_alloc_stats;
+std::string g_alloc_stats_path;
+// --cache-stats: text cache and subtree retention lines under the FPS
+bool g_cache_stats = false;
+// The UI render pass draws into its own rlgl batch; null when headless
+std::unique_ptr<UIRenderBatch> g_ui_batch;
+
 struct RenderFPS : System<window_manager::ProvidesCurrentResolution> {
   virtual ~RenderFPS() {}
   virtual void for_each_with(
@@ -74,6 +99,45 @@ struct RenderFPS : System<window_manager::ProvidesCurrentResolution> {
     raylib::DrawText(fmt::format("{}x{}", rez.width, rez.height).c_str(),
                      (int)(rez.width - 100), (int)80, (int)20,
                      raylib::RAYWHITE);
+    if (g_ui_batch) {
+      const UIRenderBatch::Frame &f = g_ui_batch->last;
+      raylib::DrawText(fmt::format("ui draws {}{} / gl {} / submits {}",
+                                   f.draws, f.partial ? "+" : "", f.gl_draws,
+                                   f.submits)
+                           .c_str(),
+                       (int)(rez.width - 360), (int)50, (int)20,
+                       raylib::RAYWHITE);
+    }
+    if (g_layout_stats) {
+      const LayoutStats::Frame &f = g_layout_stats->last;
+      raylib::DrawText(
+          fmt::format("layout {}/{}", f.dirty, f.nodes).c_str(),
+          (int)(rez.width - 160), (int)110, (int)20, raylib::RAYWHITE);
+    }
+    if (g_alloc_stats) {
+      const AllocStats::Frame &f = g_alloc_stats->last;
+      raylib::DrawText(fmt::format("allocs {} ({} KiB) ents +{}/-{}",
+                                   f.allocs, f.bytes / 1024, f.created,
+                                   f.destroyed)
+                           .c_str(),
+                       (int)(rez.width - 360), (int)140, (int)20,
+                       raylib::RAYWHITE);
+    }
+    if (g_cache_stats) {
+      const TextLayoutCache::Stats text = TextLayoutCache::get().stats();
+      raylib::DrawText(fmt::format("text cache {}/{} hit, {} KiB",
+                                   text.hits, text.hits + text.misses,
+                                   text.bytes / 1024)
+                           .c_str(),
+                       (int)(rez.width - 360), (int)170, (int)20,
+                       raylib::RAYWHITE);
+      const SubtreeRetention::Stats kept = SubtreeRetention::get().stats();
+      raylib::DrawText(
+          fmt::format("subtrees reused {} / created {}, parked {}",
+                      kept.reused, kept.created, kept.parked_entities)
+              .c_str(),
+          (int)(rez.width - 360), (int)200, (int)20, raylib::RAYWHITE);
+    }
   }
 };
 
@@ -83,6 +147,28 @@ std::optional<PlaybackConfig> g_playback_config;
 std::atomic<bool> g_should_quit{false};
 // Optional CLI-configured delay between playback steps (in seconds)
 float g_step_delay_seconds = 0.0f;
+// --headless: no window or GL context, render systems are skipped
+bool g_headless = false;
+// Set by --profile=<file>; null means no markers are registered at all
+std::unique_ptr<FrameProfiler> g_profiler;
+std::string g_profile_path;
+std::string g_profile_summary_path;
+// Supplies dt for every frame; fixed during playback so runs are repeatable
+SimClock g_clock;
+// --expect: checked against the live tree when playback finishes
+std::optional<UITreeExpectation> g_expectation;
+std::string g_expect_report_path;
+int g_exit_code = 0;
+// Set when the finished scenario went over its p95_allocs_per_frame
+std::optional<std::string> g_alloc_budget_error;
+// Set when a step's wait ran out of timeout_frames
+std::optional<std::string> g_wait_timeout_error;
+// Set when the finished scenario's [retention] counts didn't match
+std::optional<std::string> g_retention_error;
+// --retain-entities; a scenario's [retention] cap replaces it while it plays
+size_t g_retain_entities = SubtreeRetention::kDefaultCapEntities;
+// --no-action-cache: always parse the TOML
+bool g_use_action_cache = true;
 
 static std::string trim(const std::string &s) {
   size_t a = s.find_first_not_of(" \t\r\n");
@@ -112,8 +198,13 @@ static std::vector<std::string> parse_string_array(const std::string &line) {
   return out;
 }
 
+// Results are cached in .ahplay files: bump action_cache::kParserRevision
+// when a TOML starts mapping to a different config (aliases, defaults).
+// `warnings` counts what was logged and skipped, so a config that produced
+// any is never cached and its warnings show on every run.
 static std::optional<PlaybackConfig>
-load_actions_toml(const std::string &path) {
+load_actions_toml(const std::string &path, std::string_view text,
+                  size_t &warnings) {
   auto parse_action =
       [](const std::string &name) -> std::optional<InputAction> {
     if (auto a = magic_enum::enum_cast<InputAction>(name))
@@ -144,12 +235,22 @@ load_actions_toml(const std::string &path) {
     return std::nullopt;
   };
   try {
-    toml::table tbl = toml::parse_file(path);
+    toml::table tbl = toml::parse(text, path);
     PlaybackConfig cfg;
     if (auto aq = tbl["autoquit"].value<bool>())
       cfg.auto_quit = *aq;
     if (auto dp = tbl["dump_path"].value<std::string>())
       cfg.dump_path = *dp;
+    if (auto budget = tbl["p95_allocs_per_frame"].value<int64_t>()) {
+      cfg.p95_allocs_per_frame =
+          (uint32_t)std::clamp<int64_t>(*budget, 0, UINT32_MAX);
+    }
+    if (tbl.contains("max_allocs_per_frame")) {
+      warnings++;
+      log_warn("{}: max_allocs_per_frame is now p95_allocs_per_frame; "
+               "no budget is checked",
+               path);
+    }
     // Note: delay is controlled by CLI, not TOML, to keep tests deterministic
 
     // Derive scenario name from toml path (basename without extension)
@@ -179,35 +280,106 @@ load_actions_toml(const std::string &path) {
       }
     }
 
+    // Optional stress tree table
+    if (auto st = tbl["stress"].as_table()) {
+      StressTreeConfig stress;
+      if (auto n = (*st)["nodes"].value<int>())
+        stress.nodes = std::max(1, *n);
+      if (auto f = (*st)["fanout"].value<int>())
+        stress.fanout = std::max(1, *f);
+      if (auto sz = (*st)["sizing"].value<std::string>())
+        stress.sizing = *sz;
+      if (auto be = (*st)["button_every"].value<int>())
+        stress.button_every = std::max(0, *be);
+      cfg.stress = stress;
+    }
+
+    // Optional windowed list table
+    if (auto vl = tbl["virtual_list"].as_table()) {
+      VirtualListConfig list;
+      if (auto n = (*vl)["rows"].value<int64_t>())
+        list.rows = std::max<int64_t>(0, *n);
+      if (auto c = (*vl)["columns"].value<int>())
+        list.columns = std::max(1, *c);
+      if (auto h = (*vl)["row_height"].value<double>())
+        list.row_height = std::max(1.f, (float)*h);
+      if (auto st = (*vl)["scroll_step"].value<int>())
+        list.scroll_step = std::max(1, *st);
+      cfg.virtual_list = list;
+    }
+
+    // Optional searchable dropdown table
+    if (auto ta = tbl["typeahead"].as_table()) {
+      TypeaheadConfig typeahead;
+      if (auto n = (*ta)["options"].value<int>())
+        typeahead.options = std::max(0, *n);
+      if (auto q = (*ta)["query"].value<std::string>())
+        typeahead.query = *q;
+      if (auto ps = (*ta)["page_size"].value<int>())
+        typeahead.page_size = std::max(1, *ps);
+      cfg.typeahead = std::move(typeahead);
+    }
+
+    // Optional subtree retention cap and expected counts
+    if (auto rt = tbl["retention"].as_table()) {
+      RetentionConfig retention;
+      if (auto c = (*rt)["cap"].value<int64_t>())
+        retention.cap = std::max<int64_t>(0, *c);
+      if (auto n = (*rt)["reused"].value<int64_t>())
+        retention.reused = std::max<int64_t>(0, *n);
+      if (auto n = (*rt)["evicted"].value<int64_t>())
+        retention.evicted = std::max<int64_t>(0, *n);
+      cfg.retention = retention;
+    }
+
     if (auto arr = tbl["step"].as_array()) {
-      for (toml::node &node : *arr) {
-        if (auto tab = node.as_table()) {
-          PlaybackStep st;
-          if (auto pn = (*tab)["pressed"]) {
-            if (auto pa = pn.as_array()) {
-              for (toml::node &v : *pa) {
-                if (auto s = v.value<std::string>()) {
-                  if (auto action_opt = parse_action(*s))
-                    st.pressed.push_back(*action_opt);
-                  else
-                    log_warn("Unknown action in pressed: {}", *s);
-                }
-              }
-            }
-          }
-          if (auto hn = (*tab)["held"]) {
-            if (auto ha = hn.as_array()) {
-              for (toml::node &v : *ha) {
-                if (auto s = v.value<std::string>()) {
-                  if (auto action_opt = parse_action(*s))
-                    st.held.push_back(*action_opt);
-                  else
-                    log_warn("Unknown action in held: {}", *s);
-                }
+      // Reused for every step; the config keeps one flat action buffer
+      std::vector<InputAction> pressed;
+      std::vector<InputAction> held;
+      auto read_actions = [&](toml::node_view<toml::node> node,
+                              std::vector<InputAction> &into,
+                              const char *what) {
+        into.clear();
+        if (auto list = node.as_array()) {
+          for (toml::node &v : *list) {
+            if (auto s = v.value<std::string>()) {
+              if (auto action_opt = parse_action(*s)) {
+                into.push_back(*action_opt);
+              } else {
+                warnings++;
+                log_warn("Unknown action in {} of {}: {}", what, path, *s);
               }
             }
           }
-          cfg.steps.push_back(std::move(st));
+        }
+      };
+      cfg.steps.reserve(arr->size());
+      for (toml::node &node : *arr) {
+        if (auto tab = node.as_table()) {
+          read_actions((*tab)["pressed"], pressed, "pressed");
+          read_actions((*tab)["held"], held, "held");
+          auto frames_at = [&](const char *key, int64_t fallback) {
+            const int64_t v = (*tab)[key].value<int64_t>().value_or(fallback);
+            return (uint32_t)std::clamp<int64_t>(v, 0, UINT32_MAX);
+          };
+          PlaybackWait wait;
+          wait.name = (*tab)["wait_for"].value<std::string>().value_or("");
+          wait.frames = frames_at("wait_frames", 0);
+          wait.stable = frames_at("wait_stable", 0);
+          wait.timeout_frames = frames_at(
+              "timeout_frames", PlaybackWait::kDefaultTimeoutFrames);
+          const bool has_wait =
+              !wait.name.empty() || wait.frames > 0 || wait.stable > 0;
+          const bool has_repeat = (*tab)["repeat"].value<int64_t>().has_value();
+          const uint32_t idle_frames = frames_at("idle_frames", 0);
+          // A step that only says idle_frames = N idles for exactly N frames,
+          // and one that only waits takes no frames of its own
+          const bool no_input = pressed.empty() && held.empty() &&
+                                !has_repeat && (idle_frames > 0 || has_wait);
+          const uint32_t repeat_frames = no_input ? 0 : frames_at("repeat", 1);
+          cfg.add_step(pressed, held, repeat_frames, idle_frames);
+          if (has_wait)
+            cfg.steps.back().wait = cfg.add_wait(std::move(wait));
         }
       }
     }
@@ -218,6 +390,40 @@ load_actions_toml(const std::string &path) {
   }
 }
 
+// Loads a playback TOML through its .ahplay cache (see action_cache.h). The
+// TOML is still read to hash it, but only parsed when the cache is stale.
+static std::optional<PlaybackConfig> load_actions(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    log_warn("Failed opening actions TOML {}", path);
+    return std::nullopt;
+  }
+  const std::string text((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+  const uint64_t hash = action_cache::hash_bytes(text);
+  const std::string cache_path = action_cache::path_for(path);
+  if (g_use_action_cache) {
+    if (auto cached = action_cache::read(cache_path, hash))
+      return cached;
+  }
+  size_t warnings = 0;
+  auto cfg = load_actions_toml(path, text, warnings);
+  if (cfg.has_value() && g_use_action_cache && warnings == 0 &&
+      !action_cache::write(cache_path, hash, *cfg)) {
+    log_trace("Could not write action cache {}", cache_path);
+  }
+  return cfg;
+}
+
+// Allocation counting starts with the first config that has a budget, so a
+// scenario can enforce one without extra flags
+static void start_alloc_stats() {
+  if (!g_alloc_stats) {
+    g_alloc_stats = std::make_unique<AllocStats>();
+    log_info("Counting heap allocations per frame");
+  }
+}
+
 // dump_ui_tree_json moved to ui_demo/dump.h
 
 // get_mapping moved to ui_demo/input_mapping.h
@@ -257,11 +463,182 @@ struct SimpleUISystem : System<afterhours::ui::UIContext<InputAction>> {
 
 // Duplicated in src/ui_demo/router.h/cpp
 
+static void report_expect_result(const ExpectResult &res) {
+  if (res.ok) {
+    log_info("Expected tree matched");
+  } else {
+    for (const ExpectMismatch &m : res.errors)
+      log_warn("{}", m.message);
+  }
+  if (!g_expect_report_path.empty()) {
+    std::ofstream out(g_expect_report_path);
+    out << res.to_json().dump(2);
+  }
+  g_exit_code = res.ok ? 0 : 1;
+}
+
+static void add_alloc_budget_error(ExpectResult &res) {
+  if (!g_alloc_budget_error.has_value())
+    return;
+  res.ok = false;
+  res.errors.push_back(
+      ExpectMismatch{"alloc_budget", "root", *g_alloc_budget_error});
+}
+
+static void add_retention_error(ExpectResult &res) {
+  if (!g_retention_error.has_value())
+    return;
+  res.ok = false;
+  res.errors.push_back(
+      ExpectMismatch{"retention", "root", *g_retention_error});
+}
+
+static void add_wait_timeout_error(ExpectResult &res) {
+  if (!g_wait_timeout_error.has_value())
+    return;
+  res.ok = false;
+  res.errors.push_back(
+      ExpectMismatch{"wait_timeout", "root", *g_wait_timeout_error});
+}
+
 // Injects test inputs from the playback config each frame
 struct ActionPlaybackSystem : System<> {
   size_t current_step = 0;
+  // Frames already spent on the current step (repeat + idle_frames)
+  uint64_t step_frame = 0;
   bool done = false;
   float wait_timer = 0.0f;
+  // State of the current step's PlaybackWait
+  uint32_t wait_elapsed = 0;
+  uint32_t stable_frames = 0;
+  uint64_t last_tree_hash = 0;
+  bool timed_out = false;
+  // Batch --fork-prefixes holds playback here, at the start of this step
+  size_t pause_at = SIZE_MAX;
+  bool started = false;
+  // Retention counters when the scenario started; they are never reset
+  SubtreeRetention::Stats retention_at_start;
+
+  // Rewind to the first step; used by batch mode between scenarios
+  void reset() {
+    current_step = 0;
+    step_frame = 0;
+    done = false;
+    wait_timer = 0.0f;
+    timed_out = false;
+    pause_at = SIZE_MAX;
+    started = false;
+    reset_wait();
+    g_alloc_budget_error.reset();
+    g_wait_timeout_error.reset();
+    g_retention_error.reset();
+  }
+
+  void reset_wait() {
+    wait_elapsed = 0;
+    stable_frames = 0;
+    last_tree_hash = 0;
+  }
+
+  void next_step() {
+    current_step++;
+    step_frame = 0;
+    reset_wait();
+    // Reset delay timer after applying a step
+    if (g_step_delay_seconds > 0.0f) {
+      wait_timer = g_step_delay_seconds;
+    }
+  }
+
+  // Called once per frame until it returns true. Looks at the tree laid out
+  // last frame, which is the newest one there is at this point.
+  bool wait_done(const PlaybackWait &wait) {
+    wait_elapsed++;
+    bool ok = wait_elapsed > wait.frames;
+    if (!wait.name.empty() || wait.stable > 0) {
+      const UITreeProbe probe = probe_ui_tree(wait.name);
+      if (!wait.name.empty())
+        ok = ok && probe.found;
+      if (wait.stable > 0) {
+        stable_frames =
+            wait_elapsed > 1 && probe.hash == last_tree_hash
+                ? stable_frames + 1
+                : 0;
+        last_tree_hash = probe.hash;
+        ok = ok && stable_frames >= wait.stable;
+      }
+    }
+    if (ok)
+      return true;
+    if (wait_elapsed <= wait.frames ||
+        wait_elapsed - wait.frames < wait.timeout_frames)
+      return false;
+    const std::string message = fmt::format(
+        "Step {} timed out after {} frames (wait_for '{}', wait_frames {}, "
+        "wait_stable {})",
+        current_step + 1, wait_elapsed, wait.name, wait.frames, wait.stable);
+    log_warn("{}", message);
+    // The first timeout is the one worth reporting
+    if (!timed_out)
+      g_wait_timeout_error = message;
+    timed_out = true;
+    return true;
+  }
+
+  // First frame of a scenario, before the UI is built
+  void start(const PlaybackConfig &cfg) {
+    started = true;
+    SubtreeRetention &retention = SubtreeRetention::get();
+    retention.set_cap(cfg.retention && cfg.retention->cap >= 0
+                          ? (size_t)cfg.retention->cap
+                          : g_retain_entities);
+    retention_at_start = retention.stats();
+    if (g_alloc_stats)
+      g_alloc_stats->mark_scenario(cfg.p95_allocs_per_frame);
+  }
+
+  void check_retention(const RetentionConfig &expected) {
+    const SubtreeRetention::Stats now = SubtreeRetention::get().stats();
+    const int64_t reused =
+        (int64_t)(now.reused - retention_at_start.reused);
+    const int64_t evicted =
+        (int64_t)(now.evicted - retention_at_start.evicted);
+    if ((expected.reused >= 0 && reused != expected.reused) ||
+        (expected.evicted >= 0 && evicted != expected.evicted)) {
+      g_retention_error = fmt::format(
+          "retention: {} reused, {} evicted (expected {}, {})", reused,
+          evicted, expected.reused, expected.evicted);
+    }
+  }
+
+  void finish(const PlaybackConfig &cfg) {
+    done = true;
+    // Dump UI tree if requested and request quit
+    if (!cfg.dump_path.empty())
+      dump_ui_tree_json(cfg.dump_path);
+    if (g_alloc_stats) {
+      g_alloc_budget_error = g_alloc_stats->check_budget();
+      if (g_alloc_budget_error.has_value())
+        log_warn("{}", *g_alloc_budget_error);
+    }
+    if (cfg.retention.has_value()) {
+      check_retention(*cfg.retention);
+      if (g_retention_error.has_value())
+        log_warn("{}", *g_retention_error);
+    }
+    if (g_expectation.has_value()) {
+      ExpectResult res = g_expectation->check();
+      add_alloc_budget_error(res);
+      add_wait_timeout_error(res);
+      add_retention_error(res);
+      report_expect_result(res);
+    }
+    if (timed_out || g_alloc_budget_error.has_value() ||
+        g_retention_error.has_value())
+      g_exit_code = 1;
+    if (cfg.auto_quit)
+      g_should_quit = true;
+  }
 
   virtual void for_each_with(Entity &, float dt) override {
     if (!g_playback_config.has_value() || done)
@@ -272,14 +649,40 @@ struct ActionPlaybackSystem : System<> {
     // use accessors directly below, do not bind to avoid unused warnings
 
     const PlaybackConfig &cfg = g_playback_config.value();
-    if (current_step < cfg.steps.size()) {
-      // If a delay is configured (via CLI), count down before next step
-      if (g_step_delay_seconds > 0.0f && wait_timer > 0.0f) {
-        wait_timer -= dt;
+    if (!started)
+      start(cfg);
+    // If a delay is configured (via CLI), count down before the next step,
+    // and after the last one before finishing
+    if (g_step_delay_seconds > 0.0f && wait_timer > 0.0f) {
+      wait_timer -= dt;
+      return;
+    }
+    while (current_step < cfg.steps.size()) {
+      if (current_step >= pause_at)
         return;
-      }
       const PlaybackStep &step = cfg.steps[current_step];
-      for (auto a : step.held) {
+      if (step_frame == 0) {
+        if (const PlaybackWait *wait = cfg.wait_for(step);
+            wait && !wait_done(*wait))
+          return;
+      }
+      if (step.frames() > 0)
+        break;
+      // Only waited (or repeat = 0); takes no frame of its own
+      next_step();
+      if (wait_timer > 0.0f)
+        return;
+    }
+    if (current_step >= cfg.steps.size()) {
+      finish(cfg);
+      return;
+    }
+
+    // Repeats and idle frames are expanded here, one frame at a time,
+    // instead of storing a copy of the step per frame
+    const PlaybackStep &step = cfg.steps[current_step];
+    if (step_frame < step.repeat) {
+      for (auto a : cfg.held(step)) {
         pic.inputs().push_back(afterhours::input::ActionDone<InputAction>{
             .medium = input::DeviceMedium::Keyboard,
             .id = 0,
@@ -287,7 +690,7 @@ struct ActionPlaybackSystem : System<> {
             .amount_pressed = 1.f,
             .length_pressed = dt});
       }
-      for (auto a : step.pressed) {
+      for (auto a : cfg.pressed(step)) {
         pic.inputs_pressed().push_back(
             afterhours::input::ActionDone<InputAction>{
                 .medium = input::DeviceMedium::Keyboard,
@@ -296,21 +699,349 @@ struct ActionPlaybackSystem : System<> {
                 .amount_pressed = 1.f,
                 .length_pressed = dt});
       }
-      current_step++;
-      // Reset delay timer after applying a step
-      if (g_step_delay_seconds > 0.0f) {
-        wait_timer = g_step_delay_seconds;
+    }
+    if (++step_frame >= step.frames())
+      next_step();
+  }
+};
+
+// Creates the singleton entity that owns input, window and UI state.
+// Batch mode calls this again after wiping the world between scenarios.
+static void create_main_entity() {
+  auto &Sophie = EntityHelper::createEntity();
+  input::add_singleton_components<InputAction>(Sophie, get_mapping());
+  // Set desired starting resolution
+  window_manager::Resolution startRez{1920, 1080};
+  window_manager::add_singleton_components(Sophie, startRez, 200);
+  ui::add_singleton_components<InputAction>(Sophie);
+
+  // Add AutoLayoutRoot component - required for UI elements
+  Sophie.addComponent<ui::AutoLayoutRoot>();
+  // Root UIComponent so children have a valid parent
+  Sophie.addComponent<ui::UIComponent>(Sophie.id);
+  Sophie.addComponent<ui::UIComponentDebug>("root");
+  if (g_headless) {
+    // No GL context means no default font; measure text with CPU metrics
+    Sophie.get<ui::FontManager>().load_font(ui::UIComponent::DEFAULT_FONT,
+                                            null_render::make_font());
+  }
+  // Ensure newly added components are available this frame
+  EntityHelper::merge_entity_arrays();
+}
+
+static void run_frame(SystemManager &systems) {
+  FrameProfiler *prof = g_profiler.get();
+  AllocStats *allocs = g_alloc_stats.get();
+  if (allocs)
+    allocs->begin_frame();
+  if (prof)
+    prof->begin_frame();
+  if (g_headless) {
+    systems.run(g_clock.tick());
+  } else {
+    raylib::BeginDrawing();
+    { systems.run(g_clock.tick()); }
+    // Includes the SetTargetFPS wait unless --fast-forward
+    if (prof)
+      prof->begin("present");
+    raylib::EndDrawing();
+  }
+  if (prof)
+    prof->end_frame();
+  if (allocs)
+    allocs->end_frame();
+}
+
+static bool window_should_close() {
+  return !g_headless && raylib::WindowShouldClose();
+}
+
+static void close_window() {
+  if (const SubtreeRetention::Stats kept = SubtreeRetention::get().stats();
+      kept.created + kept.reused > 0) {
+    log_info("subtrees: {} reused, {} created, {} evicted; {} parked "
+             "({} entities)",
+             kept.reused, kept.created, kept.evicted, kept.parked,
+             kept.parked_entities);
+  }
+  if (const TextLayoutCache::Stats text = TextLayoutCache::get().stats();
+      text.hits + text.misses > 0) {
+    log_info("text cache: {} hits, {} misses, {} evictions, {} bypassed; "
+             "{} entries in {} KiB",
+             text.hits, text.misses, text.evictions, text.bypassed,
+             text.entries, text.bytes / 1024);
+  }
+  if (g_layout_stats) {
+    g_layout_stats->log_summary();
+    g_layout_stats.reset();
+  }
+  if (g_alloc_stats) {
+    g_alloc_stats->log_summary();
+    if (!g_alloc_stats_path.empty()) {
+      if (g_alloc_stats->write_json(g_alloc_stats_path, g_profiler.get())) {
+        log_info("Wrote allocation stats to {}", g_alloc_stats_path);
+      } else {
+        log_warn("Failed writing allocation stats to {}",
+                 g_alloc_stats_path);
       }
-    } else {
-      done = true;
-      // Dump UI tree if requested and request quit
-      dump_ui_tree_json(cfg.dump_path);
-      if (cfg.auto_quit)
-        g_should_quit = true;
     }
+    g_alloc_stats.reset();
   }
+  if (g_profiler) {
+    g_profiler->log_summary();
+    if (!g_profile_path.empty()) {
+      if (g_profiler->write_chrome_trace(g_profile_path)) {
+        log_info("Wrote frame profile to {}", g_profile_path);
+      } else {
+        log_warn("Failed writing frame profile to {}", g_profile_path);
+      }
+    }
+    if (!g_profile_summary_path.empty() &&
+        !g_profiler->write_summary_json(g_profile_summary_path)) {
+      log_warn("Failed writing profile summary to {}",
+               g_profile_summary_path);
+    }
+    g_profiler.reset();
+  }
+  if (g_ui_batch) {
+    g_ui_batch->unload();
+    g_ui_batch.reset();
+  }
+  if (!g_headless)
+    raylib::CloseWindow();
+}
+
+// Batch runs always finish on their own and keep the tree in memory
+static std::optional<PlaybackConfig>
+load_batch_actions(const BatchScenario &scn) {
+  auto cfg = load_actions(scn.toml_path);
+  if (cfg.has_value()) {
+    cfg->auto_quit = true;
+    cfg->dump_path.clear();
+    if (cfg->p95_allocs_per_frame.has_value())
+      start_alloc_stats();
+  }
+  return cfg;
+}
+
+// Checks a finished scenario against its expected tree, as a results entry
+static std::string batch_entry(const BatchScenario &scn, size_t frames,
+                               bool timed_out) {
+  std::optional<ExpectResult> verdict;
+  if (!scn.expected_path.empty()) {
+    if (auto expectation = UITreeExpectation::load(scn.expected_path))
+      verdict = expectation->check();
+    else
+      log_warn("Could not load expected tree {}", scn.expected_path);
+  }
+  if (g_alloc_budget_error.has_value() || g_retention_error.has_value() ||
+      timed_out) {
+    if (!verdict.has_value())
+      verdict = ExpectResult{};
+    add_alloc_budget_error(*verdict);
+    add_wait_timeout_error(*verdict);
+    add_retention_error(*verdict);
+  }
+  log_info("Batch scenario '{}' finished in {} frames", scn.name, frames);
+  return BatchResults::entry(scn, frames, verdict);
+}
+
+#ifdef AFTER_HOURS_BATCH_FORK
+struct ForkedBatch {
+  SystemManager &systems;
+  ActionPlaybackSystem &playback;
+  const std::vector<BatchScenario> &scenarios;
+  const std::vector<std::optional<PlaybackConfig>> &configs;
+  BatchForkResults &results;
 };
 
+static void run_batch_group(ForkedBatch &b, const std::vector<size_t> &group,
+                            size_t played, size_t frames);
+
+// Runs each branch in a child forked from the current state, one at a time
+static void
+fork_batch_branches(ForkedBatch &b,
+                    const std::vector<std::vector<size_t>> &branches,
+                    size_t played, size_t frames) {
+  for (const std::vector<size_t> &branch : branches) {
+    // Anything still buffered would otherwise be written by both processes
+    std::fflush(nullptr);
+    const pid_t pid = ::fork();
+    if (pid == 0) {
+      // The log writer thread only exists in the parent; print directly
+      async_log::instance_ptr().store(nullptr);
+      binary_log::instance_ptr().store(nullptr);
+      run_batch_group(b, branch, played, frames);
+      std::fflush(nullptr);
+      ::_exit(0);
+    }
+    if (pid < 0) {
+      log_warn("fork failed, {} scenarios get no result", branch.size());
+      continue;
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+      log_warn("Forked batch branch {} exited with status {}", pid, status);
+  }
+}
+
+// Plays `group` from a state where its first `played` steps have run: the
+// steps they still share once, then every branch in its own fork
+static void run_batch_group(ForkedBatch &b, const std::vector<size_t> &group,
+                            size_t played, size_t frames) {
+  ActionPlaybackSystem &playback = b.playback;
+  if (group.size() == 1) {
+    const size_t i = group.front();
+    g_playback_config = *b.configs[i];
+    playback.pause_at = SIZE_MAX;
+    while (!g_should_quit.load()) {
+      run_frame(b.systems);
+      frames++;
+    }
+    b.results.put((uint32_t)i,
+                  batch_entry(b.scenarios[i], frames, playback.timed_out));
+    return;
+  }
+
+  std::vector<const PlaybackConfig *> cfgs;
+  for (size_t i : group)
+    cfgs.push_back(&*b.configs[i]);
+  const size_t shared = std::max(played, shared_step_prefix(cfgs));
+  if (shared > played) {
+    g_playback_config = *b.configs[group.front()];
+    playback.pause_at = shared;
+    while (playback.current_step < shared) {
+      run_frame(b.systems);
+      frames++;
+    }
+    log_info("Played {} shared steps once for {} scenarios", shared - played,
+             group.size());
+  }
+
+  auto branches = split_batch_group(group, [&](size_t x, size_t y) {
+    return same_playback_step(*b.configs[x], shared, *b.configs[y], shared);
+  });
+  if (branches.size() == 1) {
+    // Same steps from here on; only their configs differ
+    branches = split_batch_group(group, [](size_t x, size_t y) {
+      return x == y;
+    });
+  }
+  fork_batch_branches(b, branches, shared, frames);
+}
+
+static int run_batch_forked(SystemManager &systems,
+                            ActionPlaybackSystem &playback,
+                            const std::vector<BatchScenario> &scenarios,
+                            const std::string &results_path) {
+  BatchForkResults parts;
+  if (!parts.open(results_path + ".parts")) {
+    log_warn("Failed opening batch scratch file {}.parts", results_path);
+    return 1;
+  }
+  std::vector<std::optional<PlaybackConfig>> configs;
+  std::vector<size_t> loaded;
+  for (const BatchScenario &scn : scenarios) {
+    configs.push_back(load_batch_actions(scn));
+    if (configs.back().has_value())
+      loaded.push_back(configs.size() - 1);
+  }
+  playback.reset();
+  g_should_quit = false;
+
+  // Scenarios with different [stress], [virtual_list] or [typeahead] screens,
+  // or [retention] caps, never share a prefix, and this process stays at
+  // frame 0
+  ForkedBatch b{systems, playback, scenarios, configs, parts};
+  fork_batch_branches(b,
+                      split_batch_group(loaded,
+                                        [&](size_t x, size_t y) {
+                                          return same_stress_world(
+                                              *configs[x], *configs[y]);
+                                        }),
+                      0, 0);
+
+  BatchResults results;
+  if (!results.open(results_path)) {
+    log_warn("Failed opening batch results file {}", results_path);
+    return 1;
+  }
+  const auto entries = parts.read_all(scenarios.size());
+  for (size_t i = 0; i < scenarios.size(); i++) {
+    if (!configs[i].has_value())
+      results.add_error(scenarios[i], "failed to load actions file");
+    else if (entries[i].has_value())
+      results.add_entry(*entries[i]);
+    else
+      results.add_error(scenarios[i], "forked branch produced no result");
+  }
+  if (!results.close()) {
+    log_warn("Failed writing batch results to {}", results_path);
+    return 1;
+  }
+  log_info("Wrote {} scenario results to {}", scenarios.size(), results_path);
+  return 0;
+}
+#endif
+
+// Plays every scenario under `dir` in this process, reusing the window and
+// systems and wiping the entity world in between. Each scenario's final UI
+// tree is collected into one results file instead of ui_tree.json.
+static int run_batch(SystemManager &systems, ActionPlaybackSystem &playback,
+                     const std::vector<BatchScenario> &scenarios,
+                     const std::string &results_path, bool fork_prefixes) {
+#ifdef AFTER_HOURS_BATCH_FORK
+  if (fork_prefixes)
+    return run_batch_forked(systems, playback, scenarios, results_path);
+#else
+  if (fork_prefixes)
+    log_warn("--fork-prefixes needs fork(); playing scenarios one by one");
+#endif
+  BatchResults results;
+  if (!results.open(results_path)) {
+    log_warn("Failed opening batch results file {}", results_path);
+    return 1;
+  }
+  bool first = true;
+  for (const BatchScenario &scn : scenarios) {
+    auto cfg = load_batch_actions(scn);
+    if (!cfg.has_value()) {
+      results.add_error(scn, "failed to load actions file");
+      continue;
+    }
+    g_playback_config = std::move(cfg);
+
+    if (!first) {
+      EntityHelper::delete_all_entities_NO_REALLY_I_MEAN_ALL();
+      SubtreeRetention::get().clear();
+      create_main_entity();
+    }
+    first = false;
+    playback.reset();
+    g_should_quit = false;
+
+    size_t frames = 0;
+    while (!g_should_quit.load()) {
+      if (window_should_close()) {
+        log_warn("Window closed during batch run at scenario '{}'", scn.name);
+        results.close();
+        return 1;
+      }
+      run_frame(systems);
+      frames++;
+    }
+    results.add_entry(batch_entry(scn, frames, playback.timed_out));
+  }
+
+  if (!results.close()) {
+    log_warn("Failed writing batch results to {}", results_path);
+    return 1;
+  }
+  log_info("Wrote {} scenario results to {}", scenarios.size(), results_path);
+  return 0;
+}
+
 int main(int argc, char **argv) {
   const int screenWidth = 1280;
   const int screenHeight = 720;
@@ -318,31 +1049,152 @@ int main(int argc, char **argv) {
   // Pre-parse CLI for headless/no-window mode so we can set flags before
   // InitWindow
   bool start_hidden_window = false;
+  bool fast_forward = false;
+  bool log_sync = false;
+  async_log::Config log_config;
+  std::string log_binary_path;
+  LogLevel log_binary_level = LogLevel::LOG_TRACE;
   for (int i = 1; i < argc; ++i) {
     const std::string arg = argv[i];
-    if (arg == "--no-window" || arg == "--headless") {
+    const std::string log_file_prefix = "--log-file=";
+    const std::string log_binary_prefix = "--log-binary=";
+    const std::string log_binary_level_prefix = "--log-binary-level=";
+    if (arg == "--no-window") {
       start_hidden_window = true;
+    } else if (arg == "--headless") {
+      g_headless = true;
+    } else if (arg == "--fast-forward") {
+      fast_forward = true;
+    } else if (arg == "--log-sync") {
+      log_sync = true;
+    } else if (arg == "--no-action-cache") {
+      g_use_action_cache = false;
+    } else if (arg.rfind(log_file_prefix, 0) == 0) {
+      log_config.file_path = arg.substr(log_file_prefix.size());
+    } else if (arg.rfind(log_binary_prefix, 0) == 0) {
+      log_binary_path = arg.substr(log_binary_prefix.size());
+    } else if (arg.rfind(log_binary_level_prefix, 0) == 0) {
+      // trace | info | warn | error
+      const std::string name =
+          "LOG_" + arg.substr(log_binary_level_prefix.size());
+      auto level = magic_enum::enum_cast<LogLevel>(
+          name, magic_enum::case_insensitive);
+      if (level.has_value())
+        log_binary_level = *level;
     }
   }
-  if (start_hidden_window) {
-    // Hide the window but still initialize raylib so systems depending on it
-    // work
-    raylib::SetConfigFlags(raylib::FLAG_WINDOW_HIDDEN);
-    log_info("Starting in hidden window mode (--no-window)");
+  // Logs are written by a background thread from here until main returns;
+  // queued lines are flushed before backward prints a crash trace
+  std::optional<async_log::Session> log_session;
+  if (!log_sync) {
+    log_session.emplace(log_config,
+                        backward::SignalHandling::make_default_signals());
   }
+  // Unformatted records for tools/log_decode.cpp; warnings and errors are
+  // still printed as usual
+  std::optional<binary_log::Session> binary_log_session;
+  if (!log_binary_path.empty()) {
+    binary_log_session.emplace(log_binary_path, log_binary_level);
+    if (!binary_log_session->ok)
+      log_warn("Failed opening binary log {}", log_binary_path);
+  }
+  if (g_headless) {
+    // Never touch the window/GL side of raylib; layout, input and dumps only
+    log_info("Starting in headless mode (--headless), no window or GL context");
+  } else {
+    if (start_hidden_window) {
+      // Hide the window but still initialize raylib so systems depending on
+      // it work
+      raylib::SetConfigFlags(raylib::FLAG_WINDOW_HIDDEN);
+      log_info("Starting in hidden window mode (--no-window)");
+    }
 
-  raylib::InitWindow(screenWidth, screenHeight,
-                     "UI Afterhours - Component Showcase");
-  raylib::SetTargetFPS(200);
+    raylib::InitWindow(screenWidth, screenHeight,
+                       "UI Afterhours - Component Showcase");
+    // 0 disables the cap, so EndDrawing never sleeps
+    raylib::SetTargetFPS(fast_forward ? 0 : 200);
+    g_ui_batch = std::make_unique<UIRenderBatch>();
+    g_ui_batch->load();
+  }
 
   // Parse CLI args for action playback; fallback to AH_ACTIONS env var
+  std::string actions_dir;
+  std::string batch_filter;
+  std::string results_path = "action_results.json";
+  std::string dump_override;
+  std::string trace_path;
+  std::string expect_path;
+  std::string record_path;
+  bool fork_prefixes = false;
+  bool layout_stats = false;
+  bool alloc_stats = false;
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
     const std::string prefix = "--actions=";
     const std::string delay_ms_prefix = "--delay=";
-    if (arg.rfind(prefix, 0) == 0) {
+    const std::string actions_dir_prefix = "--actions-dir=";
+    const std::string results_prefix = "--results=";
+    const std::string filter_prefix = "--filter=";
+    const std::string dump_prefix = "--dump=";
+    const std::string trace_prefix = "--trace=";
+    const std::string expect_prefix = "--expect=";
+    const std::string expect_report_prefix = "--expect-report=";
+    const std::string profile_prefix = "--profile=";
+    const std::string profile_summary_prefix = "--profile-summary=";
+    const std::string record_prefix = "--record=";
+    const std::string alloc_stats_prefix = "--alloc-stats=";
+    const std::string text_cache_prefix = "--text-cache-kb=";
+    const std::string retain_prefix = "--retain-entities=";
+    if (arg.rfind(actions_dir_prefix, 0) == 0) {
+      actions_dir = arg.substr(actions_dir_prefix.size());
+    } else if (arg.rfind(results_prefix, 0) == 0) {
+      results_path = arg.substr(results_prefix.size());
+    } else if (arg.rfind(filter_prefix, 0) == 0) {
+      batch_filter = arg.substr(filter_prefix.size());
+    } else if (arg.rfind(dump_prefix, 0) == 0) {
+      dump_override = arg.substr(dump_prefix.size());
+    } else if (arg.rfind(trace_prefix, 0) == 0) {
+      trace_path = arg.substr(trace_prefix.size());
+    } else if (arg.rfind(expect_prefix, 0) == 0) {
+      expect_path = arg.substr(expect_prefix.size());
+    } else if (arg.rfind(expect_report_prefix, 0) == 0) {
+      g_expect_report_path = arg.substr(expect_report_prefix.size());
+    } else if (arg.rfind(profile_prefix, 0) == 0) {
+      g_profile_path = arg.substr(profile_prefix.size());
+    } else if (arg.rfind(profile_summary_prefix, 0) == 0) {
+      g_profile_summary_path = arg.substr(profile_summary_prefix.size());
+    } else if (arg == "--fork-prefixes") {
+      fork_prefixes = true;
+    } else if (arg == "--layout-stats") {
+      layout_stats = true;
+    } else if (arg == "--alloc-stats") {
+      alloc_stats = true;
+    } else if (arg == "--cache-stats") {
+      g_cache_stats = true;
+    } else if (arg.rfind(alloc_stats_prefix, 0) == 0) {
+      alloc_stats = true;
+      g_alloc_stats_path = arg.substr(alloc_stats_prefix.size());
+    } else if (arg.rfind(text_cache_prefix, 0) == 0) {
+      const std::string v = arg.substr(text_cache_prefix.size());
+      try {
+        TextLayoutCache::get().set_capacity(
+            (size_t)std::max(0, std::stoi(v)) * 1024);
+      } catch (...) {
+        log_warn("Invalid --text-cache-kb value: '{}'", v);
+      }
+    } else if (arg.rfind(retain_prefix, 0) == 0) {
+      const std::string v = arg.substr(retain_prefix.size());
+      try {
+        g_retain_entities = (size_t)std::max(0, std::stoi(v));
+        SubtreeRetention::get().set_cap(g_retain_entities);
+      } catch (...) {
+        log_warn("Invalid --retain-entities value: '{}'", v);
+      }
+    } else if (arg.rfind(record_prefix, 0) == 0) {
+      record_path = arg.substr(record_prefix.size());
+    } else if (arg.rfind(prefix, 0) == 0) {
       std::string path = arg.substr(prefix.size());
-      auto cfg = load_actions_toml(path);
+      auto cfg = load_actions(path);
       if (cfg.has_value()) {
         g_playback_config = cfg;
       } else {
@@ -360,10 +1212,21 @@ int main(int argc, char **argv) {
       }
     }
   }
+  std::vector<BatchScenario> batch_scenarios;
+  if (!actions_dir.empty()) {
+    batch_scenarios = find_batch_scenarios(actions_dir, batch_filter);
+    if (batch_scenarios.empty()) {
+      log_warn("No scenarios found under {}", actions_dir);
+      close_window();
+      return 2;
+    }
+    // Batch mode owns the playback config; ignore --actions/AH_ACTIONS
+    g_playback_config = PlaybackConfig{};
+  }
   if (!g_playback_config.has_value()) {
     const char *env = std::getenv("AH_ACTIONS");
     if (env && env[0] != '\0') {
-      auto cfg = load_actions_toml(env);
+      auto cfg = load_actions(env);
       if (cfg.has_value()) {
         g_playback_config = cfg;
       } else {
@@ -371,71 +1234,185 @@ int main(int argc, char **argv) {
       }
     }
   }
+  if (!expect_path.empty()) {
+    g_expectation = UITreeExpectation::load(expect_path);
+    if (!g_expectation.has_value()) {
+      log_warn("Failed to load expected tree: {}", expect_path);
+      close_window();
+      return 2;
+    }
+  }
+  // --dump wins over the TOML dump_path so parallel runs don't share a file
+  if (g_playback_config.has_value() && !dump_override.empty()) {
+    g_playback_config->dump_path = dump_override;
+  }
+  if (alloc_stats || (g_playback_config.has_value() &&
+                      g_playback_config->p95_allocs_per_frame.has_value())) {
+    start_alloc_stats();
+  }
+  // Playback (and anything without a real frame time) steps a fixed dt, so
+  // --fast-forward only changes how fast frames happen, not what they do
+  if (g_playback_config.has_value() || g_headless || fast_forward) {
+    g_clock.use_fixed();
+    if (fast_forward)
+      log_info("Fast-forward: fixed dt {}s, frame cap off", g_clock.fixed_dt);
+  }
 
   // Create main entity
-  auto &Sophie = EntityHelper::createEntity();
-  {
-    input::add_singleton_components<InputAction>(Sophie, get_mapping());
-    // Set desired starting resolution
-    window_manager::Resolution startRez{1920, 1080};
-    window_manager::add_singleton_components(Sophie, startRez, 200);
-    ui::add_singleton_components<InputAction>(Sophie);
-
-    // Add AutoLayoutRoot component - required for UI elements
-    Sophie.addComponent<ui::AutoLayoutRoot>();
-    // Root UIComponent so children have a valid parent
-    Sophie.addComponent<ui::UIComponent>(Sophie.id);
-    Sophie.addComponent<ui::UIComponentDebug>("root");
-    // Ensure newly added components are available this frame
-    EntityHelper::merge_entity_arrays();
-  }
+  create_main_entity();
 
   SystemManager systems;
+  ActionPlaybackSystem *playback = nullptr;
+  // --alloc-stats also wants the profiler's markers for its per-system split
+  if (!g_profile_path.empty() || !g_profile_summary_path.empty() ||
+      alloc_stats) {
+    g_profiler = std::make_unique<FrameProfiler>();
+    log_info("Profiling frames");
+  }
+  FrameProfiler *prof = g_profiler.get();
 
-  // debug systems
-  {
-    window_manager::enforce_singletons(systems);
-    input::enforce_singletons<InputAction>(systems);
+  std::unique_ptr<InputRecorder> input_recorder;
+  if (!record_path.empty()) {
+    if (!batch_scenarios.empty()) {
+      log_warn("--record is ignored in batch mode");
+    } else {
+      input_recorder = std::make_unique<InputRecorder>(record_path);
+      if (input_recorder->ok()) {
+        log_info("Recording input to {}", record_path);
+      } else {
+        log_warn("Failed opening record file {}", record_path);
+        input_recorder.reset();
+      }
+    }
   }
 
-  // external plugins
-  {
-    input::register_update_systems<InputAction>(systems);
-    window_manager::register_update_systems(systems);
+  profile_update_group(systems, prof, "update", [&] {
+    // debug systems
+    profile_update_group(systems, prof, "enforce_singletons", [&] {
+      window_manager::enforce_singletons(systems);
+      input::enforce_singletons<InputAction>(systems);
+    });
+
+    // external plugins
+    profile_update_group(systems, prof, "input", [&] {
+      input::register_update_systems<InputAction>(systems);
+    });
+    // These track the real window; headless keeps the starting resolution
+    if (!g_headless) {
+      profile_update_group(systems, prof, "window_manager", [&] {
+        window_manager::register_update_systems(systems);
+      });
+    }
     if (g_playback_config.has_value()) {
-      systems.register_update_system(std::make_unique<ActionPlaybackSystem>());
+      profile_update_group(systems, prof, "ActionPlaybackSystem", [&] {
+        auto playback_system = std::make_unique<ActionPlaybackSystem>();
+        playback = playback_system.get();
+        systems.register_update_system(std::move(playback_system));
+      });
+    }
+    // After playback so re-recording a replay captures the injected input
+    if (input_recorder) {
+      profile_update_group(systems, prof, "InputRecorder", [&] {
+        InputRecorder *rec = input_recorder.get();
+        systems.register_update_system(
+            [rec](float) { rec->record_frame(); });
+      });
     }
-  }
 
-  // UI systems - add them back but with proper singleton handling
-  {
-    ui::register_before_ui_updates<InputAction>(systems);
-    {
-      // Register our UI system between before and after UI updates
+    // UI systems - add them back but with proper singleton handling
+    profile_update_group(systems, prof, "ui_before", [&] {
+      ui::register_before_ui_updates<InputAction>(systems);
+    });
+    // Register our UI system between before and after UI updates
+    profile_update_group(systems, prof, "SetupUIStylingDefaults", [&] {
       systems.register_update_system(
           std::make_unique<SetupUIStylingDefaults>());
+    });
+    profile_update_group(systems, prof, "DemoRouter", [&] {
       systems.register_update_system(std::make_unique<DemoRouter>());
+    });
+    // Includes autolayout
+    profile_update_group(systems, prof, "ui_after", [&] {
+      ui::register_after_ui_updates<InputAction>(systems);
+    });
+  });
+
+  if (layout_stats) {
+    g_layout_stats = std::make_unique<LayoutStats>();
+    LayoutStats *stats = g_layout_stats.get();
+    profile_update_group(systems, prof, "layout_stats", [&] {
+      systems.register_update_system(
+          [stats](float) { stats->record_frame(); });
+    });
+  }
+
+  // Per-frame tree deltas, recorded once layout for the frame is done
+  std::unique_ptr<UITraceRecorder> trace;
+  if (!trace_path.empty()) {
+    trace = std::make_unique<UITraceRecorder>(trace_path);
+    if (trace->ok()) {
+      UITraceRecorder *recorder = trace.get();
+      profile_update_group(systems, prof, "trace", [&] {
+        systems.register_update_system(
+            [recorder](float) { recorder->record_frame(); });
+      });
+      log_info("Recording UI tree trace to {}", trace_path);
+    } else {
+      log_warn("Failed opening trace file {}", trace_path);
+      trace.reset();
     }
-    ui::register_after_ui_updates<InputAction>(systems);
   }
 
   // renders
-  {
-    systems.register_render_system(
-        [&](float) { raylib::ClearBackground(raylib::DARKGRAY); });
-    ui::register_render_systems<InputAction>(systems);
-    systems.register_render_system(std::make_unique<RenderFPS>());
+  if (!g_headless) {
+    profile_render_group(systems, prof, "render", [&] {
+      profile_render_group(systems, prof, "clear", [&] {
+        systems.register_render_system(
+            [&](float) { raylib::ClearBackground(raylib::DARKGRAY); });
+      });
+      profile_render_group(systems, prof, "ui_render", [&] {
+        UIRenderBatch *batch = g_ui_batch.get();
+        systems.register_render_system(
+            [batch](float) { batch->begin_pass(); });
+        ui::register_render_systems<InputAction>(systems);
+        systems.register_render_system([batch](float) { batch->end_pass(); });
+      });
+      profile_render_group(systems, prof, "RenderFPS", [&] {
+        systems.register_render_system(std::make_unique<RenderFPS>());
+      });
+    });
   }
 
-  while (!raylib::WindowShouldClose()) {
-    raylib::BeginDrawing();
-    { systems.run(raylib::GetFrameTime()); }
-    raylib::EndDrawing();
+  if (!batch_scenarios.empty()) {
+    // A forked child can't share the parent's window and GL context
+    if (fork_prefixes && !g_headless) {
+      log_warn("--fork-prefixes needs --headless; playing scenarios one by "
+               "one");
+      fork_prefixes = false;
+    }
+    const int rc = run_batch(systems, *playback, batch_scenarios,
+                             results_path, fork_prefixes);
+    close_window();
+    return rc;
+  }
+
+  if (g_headless && !(g_playback_config.has_value() &&
+                      g_playback_config->auto_quit)) {
+    log_warn("--headless without an autoquit playback runs until killed");
+  }
+
+  while (!window_should_close()) {
+    run_frame(systems);
     if (g_should_quit.load())
       break;
   }
 
-  raylib::CloseWindow();
+  if (input_recorder) {
+    input_recorder->finish();
+    log_info("Wrote {} recorded frames as {} steps to {}",
+             input_recorder->frame, input_recorder->steps_written, record_path);
+  }
+  close_window();
 
-  return 0;
+  return g_exit_code;
 }
@@ -175,6 +175,27 @@ inline std::ostream &operator<<(std::ostream &os, Color c) {
 
 } // namespace raylib
 
+// Label text is measured and drawn through TextLayoutCache
+// (ui_demo/text_cache.h). The afterhours UI calls these two by name, so they
+// are redirected here, before afterhours is included; the raylib originals
+// stay reachable as the *Uncached versions.
+namespace raylib {
+inline Vector2 MeasureTextExUncached(Font font, const char *text,
+                                     float fontSize, float spacing) {
+  return MeasureTextEx(font, text, fontSize, spacing);
+}
+inline void DrawTextExUncached(Font font, const char *text, Vector2 position,
+                               float fontSize, float spacing, Color tint) {
+  DrawTextEx(font, text, position, fontSize, spacing, tint);
+}
+Vector2 MeasureTextExCached(Font font, const char *text, float fontSize,
+                            float spacing);
+void DrawTextExCached(Font font, const char *text, Vector2 position,
+                      float fontSize, float spacing, Color tint);
+} // namespace raylib
+#define MeasureTextEx MeasureTextExCached
+#define DrawTextEx DrawTextExCached
+
 #include <GLFW/glfw3.h>
 
 // We redefine the max here because the max keyboardkey is in the 300s
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "magic_enum/magic_enum.hpp"
+#include "ui_demo/playback.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define AFTER_HOURS_GETPID _getpid
+#else
+#include <unistd.h>
+#define AFTER_HOURS_GETPID getpid
+#endif
+
+// Compiled playback scripts: <scenario>.ahplay next to <scenario>.toml.
+//
+// Parsing a TOML with tens of thousands of steps (toml++ plus the action name
+// fallbacks in load_actions_toml) dominates startup, so the parsed
+// PlaybackConfig is written out once and read back with a single read. The
+// cache stores the FNV-1a hash of the TOML bytes and is ignored when it no
+// longer matches, or when kVersion changes. Actions are stored by their
+// InputAction value, so the header also carries schema_hash(): the enum's
+// names and values plus kParserRevision. Reordering or renaming InputAction
+// invalidates every cache on its own; changing how parse_action or
+// load_actions_toml reads a TOML needs a kParserRevision bump. A TOML that
+// parses with warnings (unknown actions, renamed keys) is not cached, so it
+// is parsed, and warned about, on every run until it is fixed.
+//
+// Layout (little endian, native widths):
+//   "AHPL" u32 version  u64 schema_hash  u64 toml_hash  u32 flags
+//   str dump_path  str scenario_name  str button_color
+//   i32 stress.nodes  i32 stress.fanout  i32 stress.button_every
+//   str stress.sizing  u32 p95_allocs_per_frame
+//   i64 virtual_list.rows  i32 virtual_list.columns
+//   f32 virtual_list.row_height  i32 virtual_list.scroll_step
+//   i32 typeahead.options  i32 typeahead.page_size  str typeahead.query
+//   i64 retention.cap  i64 retention.reused  i64 retention.evicted
+//   u32 steps  steps x (u32 first, u16 pressed, u16 held, u32 repeat,
+//                       u32 idle_frames, u32 wait)
+//   u32 actions  actions x u8 InputAction (PlaybackConfig::actions)
+//   u32 waits  waits x (str name, u32 frames, u32 stable, u32 timeout_frames)
+// where str is u32 length + bytes.
+namespace action_cache {
+
+constexpr char kMagic[4] = {'A', 'H', 'P', 'L'};
+constexpr uint32_t kVersion = 8;
+// Bump when the TOML -> PlaybackConfig mapping changes (action aliases,
+// defaults, clamping) without a change to the file layout
+constexpr uint32_t kParserRevision = 3;
+
+// Header flags
+constexpr uint32_t AutoQuit = 1u << 0;
+constexpr uint32_t HasLabelSet = 1u << 1;
+constexpr uint32_t HasLabel = 1u << 2;
+constexpr uint32_t DisabledSet = 1u << 3;
+constexpr uint32_t Disabled = 1u << 4;
+constexpr uint32_t ColorSet = 1u << 5;
+constexpr uint32_t StressSet = 1u << 6;
+constexpr uint32_t AllocBudgetSet = 1u << 7;
+constexpr uint32_t VirtualListSet = 1u << 8;
+constexpr uint32_t TypeaheadSet = 1u << 9;
+constexpr uint32_t RetentionSet = 1u << 10;
+
+inline uint64_t hash_bytes(std::string_view bytes,
+                           uint64_t h = 1469598103934665603ull) {
+  for (unsigned char c : bytes) {
+    h ^= c;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+inline uint64_t schema_hash() {
+  uint64_t h = hash_bytes(std::string_view(
+      (const char *)&kParserRevision, sizeof(kParserRevision)));
+  constexpr auto names = magic_enum::enum_names<InputAction>();
+  constexpr auto values = magic_enum::enum_values<InputAction>();
+  for (size_t i = 0; i < names.size(); i++) {
+    const auto value = (uint8_t)values[i];
+    h = hash_bytes(names[i], h);
+    h = hash_bytes(std::string_view((const char *)&value, 1), h);
+  }
+  return h;
+}
+
+// actions/foo/foo.toml -> actions/foo/foo.ahplay
+inline std::string path_for(const std::string &toml_path) {
+  const size_t slash = toml_path.find_last_of("/\\");
+  const size_t dot = toml_path.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return toml_path + ".ahplay";
+  return toml_path.substr(0, dot) + ".ahplay";
+}
+
+struct Writer {
+  std::string out;
+
+  template <typename T> void pod(const T &v) {
+    out.append((const char *)&v, sizeof(T));
+  }
+  void str(const std::string &s) {
+    pod((uint32_t)s.size());
+    out.append(s);
+  }
+};
+
+struct Reader {
+  std::string_view in;
+  size_t pos = 0;
+  bool ok = true;
+
+  template <typename T> T pod() {
+    T v{};
+    if (in.size() - pos < sizeof(T)) {
+      ok = false;
+      return v;
+    }
+    std::memcpy(&v, in.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return v;
+  }
+  std::string str() {
+    const uint32_t len = pod<uint32_t>();
+    if (!ok || in.size() - pos < len) {
+      ok = false;
+      return {};
+    }
+    std::string s(in.substr(pos, len));
+    pos += len;
+    return s;
+  }
+};
+
+inline bool write(const std::string &path, uint64_t toml_hash,
+                  const PlaybackConfig &cfg) {
+  Writer w;
+  w.out.append(kMagic, sizeof(kMagic));
+  w.pod(kVersion);
+  w.pod(schema_hash());
+  w.pod(toml_hash);
+  uint32_t flags = cfg.auto_quit ? AutoQuit : 0u;
+  if (cfg.button_has_label.has_value())
+    flags |= HasLabelSet | (*cfg.button_has_label ? HasLabel : 0u);
+  if (cfg.button_disabled.has_value())
+    flags |= DisabledSet | (*cfg.button_disabled ? Disabled : 0u);
+  if (cfg.button_color.has_value())
+    flags |= ColorSet;
+  if (cfg.stress.has_value())
+    flags |= StressSet;
+  if (cfg.p95_allocs_per_frame.has_value())
+    flags |= AllocBudgetSet;
+  if (cfg.virtual_list.has_value())
+    flags |= VirtualListSet;
+  if (cfg.typeahead.has_value())
+    flags |= TypeaheadSet;
+  if (cfg.retention.has_value())
+    flags |= RetentionSet;
+  w.pod(flags);
+  w.str(cfg.dump_path);
+  w.str(cfg.scenario_name);
+  w.str(cfg.button_color.value_or(""));
+  const StressTreeConfig stress = cfg.stress.value_or(StressTreeConfig{});
+  w.pod((int32_t)stress.nodes);
+  w.pod((int32_t)stress.fanout);
+  w.pod((int32_t)stress.button_every);
+  w.str(stress.sizing);
+  w.pod(cfg.p95_allocs_per_frame.value_or(0));
+  const VirtualListConfig list =
+      cfg.virtual_list.value_or(VirtualListConfig{});
+  w.pod(list.rows);
+  w.pod((int32_t)list.columns);
+  w.pod(list.row_height);
+  w.pod((int32_t)list.scroll_step);
+  const TypeaheadConfig typeahead =
+      cfg.typeahead.value_or(TypeaheadConfig{});
+  w.pod((int32_t)typeahead.options);
+  w.pod((int32_t)typeahead.page_size);
+  w.str(typeahead.query);
+  const RetentionConfig retention =
+      cfg.retention.value_or(RetentionConfig{});
+  w.pod(retention.cap);
+  w.pod(retention.reused);
+  w.pod(retention.evicted);
+
+  w.pod((uint32_t)cfg.steps.size());
+  for (const PlaybackStep &st : cfg.steps) {
+    w.pod(st.first);
+    w.pod(st.pressed_count);
+    w.pod(st.held_count);
+    w.pod(st.repeat);
+    w.pod(st.idle_frames);
+    w.pod(st.wait);
+  }
+  w.pod((uint32_t)cfg.actions.size());
+  for (InputAction a : cfg.actions)
+    w.out.push_back((char)a);
+  w.pod((uint32_t)cfg.waits.size());
+  for (const PlaybackWait &wait : cfg.waits) {
+    w.str(wait.name);
+    w.pod(wait.frames);
+    w.pod(wait.stable);
+    w.pod(wait.timeout_frames);
+  }
+
+  // Write to a temp file and rename so a parallel run never reads half of
+  // it; per process, so two runs writing the same cache don't share one
+  const std::string tmp =
+      path + "." + std::to_string(AFTER_HOURS_GETPID()) + ".tmp";
+  {
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f)
+      return false;
+    f.write(w.out.data(), (std::streamsize)w.out.size());
+    if (!f)
+      return false;
+  }
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// nullopt when missing, stale (hashes or version) or malformed
+inline std::optional<PlaybackConfig> read(const std::string &path,
+                                          uint64_t toml_hash) {
+  std::ifstream f(path, std::ios::binary | std::ios::ate);
+  if (!f)
+    return std::nullopt;
+  std::string bytes((size_t)f.tellg(), '\0');
+  f.seekg(0);
+  if (!f.read(bytes.data(), (std::streamsize)bytes.size()))
+    return std::nullopt;
+
+  Reader r{bytes};
+  if (bytes.size() < sizeof(kMagic) ||
+      std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0)
+    return std::nullopt;
+  r.pos = sizeof(kMagic);
+  if (r.pod<uint32_t>() != kVersion || r.pod<uint64_t>() != schema_hash() ||
+      r.pod<uint64_t>() != toml_hash)
+    return std::nullopt;
+
+  PlaybackConfig cfg;
+  const uint32_t flags = r.pod<uint32_t>();
+  cfg.auto_quit = flags & AutoQuit;
+  if (flags & HasLabelSet)
+    cfg.button_has_label = (flags & HasLabel) != 0;
+  if (flags & DisabledSet)
+    cfg.button_disabled = (flags & Disabled) != 0;
+  cfg.dump_path = r.str();
+  cfg.scenario_name = r.str();
+  std::string color = r.str();
+  if (flags & ColorSet)
+    cfg.button_color = std::move(color);
+  StressTreeConfig stress;
+  stress.nodes = r.pod<int32_t>();
+  stress.fanout = r.pod<int32_t>();
+  stress.button_every = r.pod<int32_t>();
+  stress.sizing = r.str();
+  if (flags & StressSet)
+    cfg.stress = stress;
+  const uint32_t alloc_budget = r.pod<uint32_t>();
+  if (flags & AllocBudgetSet)
+    cfg.p95_allocs_per_frame = alloc_budget;
+  VirtualListConfig list;
+  list.rows = r.pod<int64_t>();
+  list.columns = r.pod<int32_t>();
+  list.row_height = r.pod<float>();
+  list.scroll_step = r.pod<int32_t>();
+  if (flags & VirtualListSet)
+    cfg.virtual_list = list;
+  TypeaheadConfig typeahead;
+  typeahead.options = r.pod<int32_t>();
+  typeahead.page_size = r.pod<int32_t>();
+  typeahead.query = r.str();
+  if (flags & TypeaheadSet)
+    cfg.typeahead = std::move(typeahead);
+  RetentionConfig retention;
+  retention.cap = r.pod<int64_t>();
+  retention.reused = r.pod<int64_t>();
+  retention.evicted = r.pod<int64_t>();
+  if (flags & RetentionSet)
+    cfg.retention = retention;
+
+  constexpr size_t kStepBytes = 5 * sizeof(uint32_t);
+  const uint32_t steps = r.pod<uint32_t>();
+  if (!r.ok || (bytes.size() - r.pos) / kStepBytes < steps)
+    return std::nullopt;
+  cfg.steps.resize(steps);
+  for (PlaybackStep &st : cfg.steps) {
+    st.first = r.pod<uint32_t>();
+    st.pressed_count = r.pod<uint16_t>();
+    st.held_count = r.pod<uint16_t>();
+    st.repeat = r.pod<uint32_t>();
+    st.idle_frames = r.pod<uint32_t>();
+    st.wait = r.pod<uint32_t>();
+  }
+  const uint32_t actions = r.pod<uint32_t>();
+  if (!r.ok || bytes.size() - r.pos < actions)
+    return std::nullopt;
+  cfg.actions.reserve(actions);
+  for (uint32_t i = 0; i < actions; i++) {
+    const auto a = (InputAction)r.pod<uint8_t>();
+    if (!magic_enum::enum_contains(a))
+      return std::nullopt;
+    cfg.actions.push_back(a);
+  }
+
+  const uint32_t waits = r.pod<uint32_t>();
+  if (!r.ok || (bytes.size() - r.pos) / (4 * sizeof(uint32_t)) < waits)
+    return std::nullopt;
+  cfg.waits.resize(waits);
+  for (PlaybackWait &wait : cfg.waits) {
+    wait.name = r.str();
+    wait.frames = r.pod<uint32_t>();
+    wait.stable = r.pod<uint32_t>();
+    wait.timeout_frames = r.pod<uint32_t>();
+  }
+  if (!r.ok || r.pos != bytes.size())
+    return std::nullopt;
+
+  for (const PlaybackStep &st : cfg.steps) {
+    if ((uint64_t)st.first + st.pressed_count + st.held_count > actions ||
+        st.wait > waits)
+      return std::nullopt;
+  }
+  return cfg;
+}
+
+} // namespace action_cache
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "rl.h"
+#include "ui_demo/alloc_tracker.h"
+#include "ui_demo/profiler.h"
+#include <fmt/format.h>
+
+// Per-frame allocation and entity churn for --alloc-stats and scenario
+// budgets. Heap counts are taken around the whole frame in run_frame; the
+// per-system split comes from the profiler's spans, which carry the same
+// counts (see FrameProfiler::Span).
+//
+// Entity churn is the set difference of live entity ids between the end of
+// one frame and the end of the next, so an entity created and cleaned up
+// within a single frame is not seen.
+struct AllocStats {
+  static constexpr size_t kRingFrames = 4096;
+
+  struct Frame {
+    uint64_t allocs = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;
+    uint32_t entities = 0;
+    uint32_t created = 0;
+    uint32_t destroyed = 0;
+  };
+
+  std::vector<Frame> ring = std::vector<Frame>(kRingFrames);
+  uint64_t frame = 0;
+  Frame last;
+  // First frame of the scenario being played, for check_budget()
+  uint64_t scenario_start = 0;
+  // The scenario's p95_allocs_per_frame. Frames are counted against it as
+  // they end rather than from the ring, so a scenario longer than
+  // kRingFrames is still checked in full.
+  std::optional<uint32_t> budget;
+  uint64_t budget_frames = 0;
+  uint64_t over_budget = 0;
+  uint64_t budget_max = 0;
+  alloc_tracker::Counts at_begin;
+
+  // Sorted live ids, this frame and last; reused so they stop growing
+  std::vector<afterhours::EntityID> ids;
+  std::vector<afterhours::EntityID> prev_ids;
+
+  AllocStats() { alloc_tracker::enabled = true; }
+  ~AllocStats() { alloc_tracker::enabled = false; }
+
+  void begin_frame() { at_begin = alloc_tracker::counts(); }
+
+  void end_frame() {
+    const alloc_tracker::Counts now = alloc_tracker::counts();
+    Frame f;
+    f.allocs = now.allocs - at_begin.allocs;
+    f.frees = now.frees - at_begin.frees;
+    f.bytes = now.bytes - at_begin.bytes;
+
+    // Outside the counted window, so growing `ids` is never charged
+    ids.clear();
+    for (const auto &e : afterhours::EntityHelper::get_entities()) {
+      if (e)
+        ids.push_back(e->id);
+    }
+    std::sort(ids.begin(), ids.end());
+    size_t kept = 0;
+    for (size_t i = 0, j = 0; i < ids.size() && j < prev_ids.size();) {
+      if (ids[i] < prev_ids[j]) {
+        i++;
+      } else if (prev_ids[j] < ids[i]) {
+        j++;
+      } else {
+        kept++;
+        i++;
+        j++;
+      }
+    }
+    f.entities = (uint32_t)ids.size();
+    f.created = (uint32_t)(ids.size() - kept);
+    f.destroyed = (uint32_t)(prev_ids.size() - kept);
+    std::swap(ids, prev_ids);
+
+    if (budget.has_value() && frame > scenario_start) {
+      budget_frames++;
+      over_budget += f.allocs > *budget ? 1 : 0;
+      budget_max = std::max(budget_max, f.allocs);
+    }
+
+    last = f;
+    ring[frame % kRingFrames] = f;
+    frame++;
+  }
+
+  // Called on the scenario's first frame, which builds the whole screen and
+  // is left out of the budget
+  void mark_scenario(std::optional<uint32_t> scenario_budget) {
+    scenario_start = frame;
+    budget = scenario_budget;
+    budget_frames = 0;
+    over_budget = 0;
+    budget_max = 0;
+  }
+
+  size_t frames_held() const {
+    return (size_t)std::min<uint64_t>(frame, kRingFrames);
+  }
+
+  // Allocation counts of frames [from, frame) still in the ring, sorted
+  std::vector<uint64_t> sorted_allocs(uint64_t from) const {
+    from = std::max(from, frame - frames_held());
+    std::vector<uint64_t> out;
+    out.reserve((size_t)(frame - std::min(from, frame)));
+    for (uint64_t i = from; i < frame; i++)
+      out.push_back(ring[i % kRingFrames].allocs);
+    std::sort(out.begin(), out.end());
+    return out;
+  }
+
+  static uint64_t pct(const std::vector<uint64_t> &sorted, size_t p) {
+    const size_t n = sorted.size();
+    return sorted[std::min(n - 1, n * p / 100)];
+  }
+
+  // Compares the scenario's p95 allocations per frame with its budget. The
+  // p95 (same rank as pct()) is above the budget exactly when at least
+  // n - rank frames are, so the counts are enough. A few one-off frames
+  // (opening an overlay) may go over as long as the scenario idles for a
+  // while. Returns the failure message.
+  std::optional<std::string> check_budget() const {
+    const uint64_t n = budget_frames;
+    if (!budget.has_value() || n == 0)
+      return std::nullopt;
+    const uint64_t rank = std::min(n - 1, n * 95 / 100);
+    if (over_budget < n - rank)
+      return std::nullopt;
+    return fmt::format("allocations per frame p95 exceeds "
+                       "p95_allocs_per_frame {}: {} of {} frames over it "
+                       "(max {})",
+                       *budget, over_budget, n, budget_max);
+  }
+
+  void log_summary() const {
+    const size_t n = frames_held();
+    if (n == 0)
+      return;
+    uint64_t bytes_total = 0;
+    uint64_t created = 0;
+    uint64_t destroyed = 0;
+    for (size_t i = 0; i < n; i++) {
+      bytes_total += ring[i].bytes;
+      created += ring[i].created;
+      destroyed += ring[i].destroyed;
+    }
+    const std::vector<uint64_t> allocs = sorted_allocs(0);
+    log_info("allocs: last {} frames, p50 {} / p95 {} / max {} allocations "
+             "per frame, {:.1f} KiB per frame, {} entities created and {} "
+             "destroyed",
+             n, pct(allocs, 50), pct(allocs, 95), allocs.back(),
+             (double)bytes_total / (double)n / 1024.0, created, destroyed);
+  }
+
+  // Totals, per-system allocations from `profiler` (if any) and every frame
+  // in the ring as [allocs, frees, bytes, entities, created, destroyed]
+  bool write_json(const std::string &path,
+                  const FrameProfiler *profiler) const {
+    std::ofstream out(path);
+    if (!out)
+      return false;
+    const size_t n = frames_held();
+    fmt::memory_buffer buf;
+    auto inserter = std::back_inserter(buf);
+    const std::vector<uint64_t> allocs = sorted_allocs(0);
+    fmt::format_to(inserter, "{{\"frames\":{},\"allocs\":{{", n);
+    if (!allocs.empty()) {
+      fmt::format_to(inserter, "\"p50\":{},\"p95\":{},\"max\":{}",
+                     pct(allocs, 50), pct(allocs, 95), allocs.back());
+    }
+    fmt::format_to(inserter, "}},\"systems\":{{");
+    if (profiler) {
+      bool first = true;
+      for (const FrameProfiler::Summary &s : profiler->summarize()) {
+        fmt::format_to(inserter,
+                       "{}\"{}\":{{\"samples\":{},\"allocs_mean\":{:.2f},"
+                       "\"allocs_max\":{},\"bytes_mean\":{:.1f}}}",
+                       first ? "" : ",", s.name, s.samples, s.allocs_mean,
+                       s.allocs_max, s.bytes_mean);
+        first = false;
+      }
+    }
+    fmt::format_to(inserter, "}},\"per_frame\":[");
+    for (uint64_t i = frame - n; i < frame; i++) {
+      const Frame &f = ring[i % kRingFrames];
+      fmt::format_to(inserter, "{}[{},{},{},{},{},{}]",
+                     i == frame - n ? "" : ",", f.allocs, f.frees, f.bytes,
+                     f.entities, f.created, f.destroyed);
+    }
+    fmt::format_to(inserter, "]}}\n");
+    out.write(buf.data(), (std::streamsize)buf.size());
+    return !out.fail();
+  }
+};
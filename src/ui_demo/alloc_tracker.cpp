@@ -0,0 +1,133 @@
+// Replaceable global allocation functions, counted by alloc_tracker.h. They
+// forward to malloc/free (or the aligned variants) exactly like the default
+// ones, including the new_handler retry loop.
+#include <cstdlib>
+#include <new>
+
+#include "ui_demo/alloc_tracker.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+void *checked_alloc(std::size_t n) {
+  alloc_tracker::note_alloc(n);
+  if (n == 0)
+    n = 1;
+  for (;;) {
+    if (void *p = std::malloc(n))
+      return p;
+    std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void *checked_alloc(std::size_t n, std::align_val_t al) {
+  alloc_tracker::note_alloc(n);
+  const std::size_t align = (std::size_t)al;
+  // aligned_alloc wants a non-zero multiple of the alignment
+  const std::size_t size = n == 0 ? align : (n + align - 1) / align * align;
+  for (;;) {
+#ifdef _WIN32
+    void *p = _aligned_malloc(size, align);
+#else
+    void *p = std::aligned_alloc(align, size);
+#endif
+    if (p)
+      return p;
+    std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void release(void *p) noexcept {
+  alloc_tracker::note_free(p);
+  std::free(p);
+}
+
+void release_aligned(void *p) noexcept {
+  alloc_tracker::note_free(p);
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+} // namespace
+
+void *operator new(std::size_t n) { return checked_alloc(n); }
+void *operator new[](std::size_t n) { return checked_alloc(n); }
+void *operator new(std::size_t n, std::align_val_t al) {
+  return checked_alloc(n, al);
+}
+void *operator new[](std::size_t n, std::align_val_t al) {
+  return checked_alloc(n, al);
+}
+
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept {
+  try {
+    return checked_alloc(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+  try {
+    return checked_alloc(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new(std::size_t n, std::align_val_t al,
+                   const std::nothrow_t &) noexcept {
+  try {
+    return checked_alloc(n, al);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t n, std::align_val_t al,
+                     const std::nothrow_t &) noexcept {
+  try {
+    return checked_alloc(n, al);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  release(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+  release_aligned(p);
+}
+void operator delete[](void *p, std::align_val_t) noexcept {
+  release_aligned(p);
+}
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  release_aligned(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  release_aligned(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  release_aligned(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  release_aligned(p);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation counts for --alloc-stats and p95_allocs_per_frame.
+//
+// alloc_tracker.cpp replaces the global operator new/delete. The hooks always
+// exist, but only count while `enabled` is set, so a normal run pays one
+// relaxed load per allocation. Bytes are what was asked for; frees are calls,
+// since a plain delete doesn't know the size.
+namespace alloc_tracker {
+
+inline std::atomic<bool> enabled{false};
+inline std::atomic<uint64_t> allocs{0};
+inline std::atomic<uint64_t> frees{0};
+inline std::atomic<uint64_t> bytes{0};
+
+struct Counts {
+  uint64_t allocs = 0;
+  uint64_t frees = 0;
+  uint64_t bytes = 0;
+};
+
+inline void note_alloc(size_t n) {
+  if (!enabled.load(std::memory_order_relaxed))
+    return;
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  bytes.fetch_add(n, std::memory_order_relaxed);
+}
+
+inline void note_free(void *p) {
+  if (p && enabled.load(std::memory_order_relaxed))
+    frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Totals since the process started counting
+inline Counts counts() {
+  return Counts{allocs.load(std::memory_order_relaxed),
+                frees.load(std::memory_order_relaxed),
+                bytes.load(std::memory_order_relaxed)};
+}
+
+} // namespace alloc_tracker
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "ui_demo/dump.h"
+#include "ui_demo/expect.h"
+#include <nlohmann/json.hpp>
+
+// One scenario directory under actions/: exactly one .toml with the playback
+// steps, and usually one expected .json (meta.json is only read by the runner)
+struct BatchScenario {
+  std::string name;          // directory name, matches run_actions.js
+  std::string toml_path;     // playback file inside the directory
+  std::string expected_path; // expected subset tree, empty if there is none
+};
+
+// Collects every scenario directory under `dir`, sorted by name so batch
+// results are stable across platforms. `filter` is a substring match on the
+// directory name, same as the runner's positional filter.
+inline std::vector<BatchScenario>
+find_batch_scenarios(const std::string &dir, const std::string &filter) {
+  namespace fs = std::filesystem;
+  std::vector<BatchScenario> out;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(dir, ec)) {
+    if (!entry.is_directory())
+      continue;
+    const std::string name = entry.path().filename().string();
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+      continue;
+
+    std::vector<std::string> tomls;
+    std::vector<std::string> expected;
+    for (const auto &f : fs::directory_iterator(entry.path(), ec)) {
+      if (!f.is_regular_file())
+        continue;
+      if (f.path().extension() == ".toml")
+        tomls.push_back(f.path().string());
+      else if (f.path().extension() == ".json" &&
+               f.path().filename() != "meta.json")
+        expected.push_back(f.path().string());
+    }
+    if (tomls.size() != 1) {
+      log_warn("Skipping scenario '{}': expected exactly one .toml, found {}",
+               name, tomls.size());
+      continue;
+    }
+    out.push_back(BatchScenario{
+        .name = name,
+        .toml_path = tomls.front(),
+        .expected_path = expected.size() == 1 ? expected.front() : ""});
+  }
+  if (ec) {
+    log_warn("Failed reading actions dir {}: {}", dir, ec.message());
+  }
+  std::sort(out.begin(), out.end(),
+            [](const BatchScenario &a, const BatchScenario &b) {
+              return a.name < b.name;
+            });
+  return out;
+}
+
+// Streams the per-scenario outcome of a batch run into a single results
+// file that run_actions.js --batch reads back:
+//   {"scenarios": [{"name", "toml", "frames", "ok", "errors",
+//                   "tree": {"root": ...}}, ...]}
+// "ok"/"errors" are the in-process --expect verdict against the scenario's
+// expected .json; the tree is only written when there is no verdict or it
+// failed. Scenarios that could not be loaded get an "error" string instead.
+struct BatchResults {
+  std::ofstream out;
+  size_t count = 0;
+
+  bool open(const std::string &path) {
+    out.open(path, std::ios::binary);
+    if (!out)
+      return false;
+    out << "{\"scenarios\":[";
+    return true;
+  }
+
+  // Records the verdict and, when it is missing or failed, the live tree
+  void add(const BatchScenario &scn, size_t frames,
+           const std::optional<ExpectResult> &verdict) {
+    add_entry(entry(scn, frames, verdict));
+  }
+
+  void add_error(const BatchScenario &scn, const std::string &error) {
+    add_entry(error_entry(scn, error));
+  }
+
+  // One element of the "scenarios" array, as built by entry()/error_entry()
+  void add_entry(const std::string &json) {
+    if (count++ > 0)
+      out << ',';
+    out << json;
+  }
+
+  bool close() {
+    out << "]}";
+    out.close();
+    return !out.fail();
+  }
+
+  static std::string entry(const BatchScenario &scn, size_t frames,
+                           const std::optional<ExpectResult> &verdict) {
+    std::ostringstream e;
+    begin_entry(e, scn);
+    e << ",\"frames\":" << frames;
+    if (verdict.has_value()) {
+      const nlohmann::json v = verdict->to_json();
+      e << ",\"ok\":" << v["ok"].dump() << ",\"errors\":" << v["errors"].dump();
+    }
+    if (!verdict.has_value() || !verdict->ok) {
+      e << ",\"tree\":";
+      write_ui_tree(e, UITreeFormat::Json);
+    }
+    e << '}';
+    return std::move(e).str();
+  }
+
+  static std::string error_entry(const BatchScenario &scn,
+                                 const std::string &error) {
+    std::ostringstream e;
+    begin_entry(e, scn);
+    e << ",\"error\":" << nlohmann::json(error).dump() << '}';
+    return std::move(e).str();
+  }
+
+private:
+  static void begin_entry(std::ostream &e, const BatchScenario &scn) {
+    e << "{\"name\":" << nlohmann::json(scn.name).dump()
+      << ",\"toml\":" << nlohmann::json(scn.toml_path).dump();
+  }
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "ui_demo/playback.h"
+
+// Batch runs with --fork-prefixes: scenarios are grouped into a prefix tree
+// by their steps, each shared prefix is played once, and every branch
+// continues in a fork()ed copy of the process. fork() is the checkpoint: the
+// child gets the whole entity world (demo state included) and the playback
+// position exactly as they were, and the parent's copy is left
+// untouched for the next branch.
+//
+// Only scenarios with the same [stress] table share a prefix, since that
+// decides which tree exists at all. Other tables (e.g. [button]) only change
+// how the example is drawn, so a branch switches to its own config and always
+// plays at least its last step with it; see shared_step_prefix().
+//
+// POSIX only; elsewhere batch mode plays scenarios one after another.
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define AFTER_HOURS_BATCH_FORK
+#endif
+
+inline bool same_playback_step(const PlaybackConfig &a, size_t i,
+                               const PlaybackConfig &b, size_t j) {
+  const PlaybackStep &x = a.steps[i];
+  const PlaybackStep &y = b.steps[j];
+  if (x.repeat != y.repeat || x.idle_frames != y.idle_frames)
+    return false;
+  const auto xp = a.pressed(x), yp = b.pressed(y);
+  const auto xh = a.held(x), yh = b.held(y);
+  if (!std::ranges::equal(xp, yp) || !std::ranges::equal(xh, yh))
+    return false;
+  const PlaybackWait *xw = a.wait_for(x);
+  const PlaybackWait *yw = b.wait_for(y);
+  if (!xw || !yw)
+    return xw == yw;
+  return xw->name == yw->name && xw->frames == yw->frames &&
+         xw->stable == yw->stable && xw->timeout_frames == yw->timeout_frames;
+}
+
+inline bool same_stress_world(const PlaybackConfig &a,
+                              const PlaybackConfig &b) {
+  if (a.virtual_list.has_value() != b.virtual_list.has_value())
+    return false;
+  if (a.virtual_list) {
+    const VirtualListConfig &x = *a.virtual_list, &y = *b.virtual_list;
+    if (x.rows != y.rows || x.columns != y.columns ||
+        x.row_height != y.row_height || x.scroll_step != y.scroll_step)
+      return false;
+  }
+  if (a.typeahead.has_value() != b.typeahead.has_value())
+    return false;
+  if (a.typeahead) {
+    const TypeaheadConfig &x = *a.typeahead, &y = *b.typeahead;
+    if (x.options != y.options || x.query != y.query ||
+        x.page_size != y.page_size)
+      return false;
+  }
+  // The cap applies from the first frame, so it can't change mid-prefix
+  const int64_t cap_a = a.retention ? a.retention->cap : -1;
+  const int64_t cap_b = b.retention ? b.retention->cap : -1;
+  if (cap_a != cap_b)
+    return false;
+  if (!a.stress || !b.stress)
+    return a.stress.has_value() == b.stress.has_value();
+  return a.stress->nodes == b.stress->nodes &&
+         a.stress->fanout == b.stress->fanout &&
+         a.stress->sizing == b.stress->sizing &&
+         a.stress->button_every == b.stress->button_every;
+}
+
+// Steps every config starts with, capped one short of the shortest so each
+// scenario still plays its last step with its own config
+inline size_t
+shared_step_prefix(const std::vector<const PlaybackConfig *> &cfgs) {
+  size_t shortest = SIZE_MAX;
+  for (const PlaybackConfig *cfg : cfgs)
+    shortest = std::min(shortest, cfg->steps.size());
+  if (cfgs.empty() || shortest == 0)
+    return 0;
+  size_t n = 0;
+  while (n + 1 < shortest) {
+    for (const PlaybackConfig *cfg : cfgs) {
+      if (!same_playback_step(*cfgs.front(), n, *cfg, n))
+        return n;
+    }
+    n++;
+  }
+  return n;
+}
+
+// Splits `group` (scenario indices) by `same`, keeping first-seen order
+template <typename Same>
+inline std::vector<std::vector<size_t>>
+split_batch_group(const std::vector<size_t> &group, Same same) {
+  std::vector<std::vector<size_t>> out;
+  for (size_t i : group) {
+    auto it = std::find_if(out.begin(), out.end(), [&](const auto &branch) {
+      return same(branch.front(), i);
+    });
+    if (it == out.end())
+      out.push_back({i});
+    else
+      it->push_back(i);
+  }
+  return out;
+}
+
+#ifdef AFTER_HOURS_BATCH_FORK
+// Results from forked branches, appended to an unlinked temp file as
+//   u32 scenario index, u32 length, length bytes of BatchResults entry
+// Branches run one at a time, so O_APPEND writes never interleave.
+struct BatchForkResults {
+  int fd = -1;
+
+  bool open(const std::string &path) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0600);
+    if (fd < 0)
+      return false;
+    ::unlink(path.c_str());
+    return true;
+  }
+
+  ~BatchForkResults() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  void put(uint32_t index, const std::string &entry) {
+    std::string rec(2 * sizeof(uint32_t), '\0');
+    const uint32_t len = (uint32_t)entry.size();
+    std::memcpy(rec.data(), &index, sizeof(index));
+    std::memcpy(rec.data() + sizeof(index), &len, sizeof(len));
+    rec += entry;
+    for (size_t done = 0; done < rec.size();) {
+      const ssize_t n = ::write(fd, rec.data() + done, rec.size() - done);
+      if (n <= 0)
+        return;
+      done += (size_t)n;
+    }
+  }
+
+  // Entry per scenario index; nullopt where a branch never reported
+  std::vector<std::optional<std::string>> read_all(size_t scenarios) const {
+    std::vector<std::optional<std::string>> out(scenarios);
+    std::string bytes;
+    char buf[1 << 16];
+    ::lseek(fd, 0, SEEK_SET);
+    for (ssize_t n; (n = ::read(fd, buf, sizeof(buf))) > 0;)
+      bytes.append(buf, (size_t)n);
+    size_t pos = 0;
+    while (bytes.size() - pos >= 2 * sizeof(uint32_t)) {
+      uint32_t index = 0, len = 0;
+      std::memcpy(&index, bytes.data() + pos, sizeof(index));
+      std::memcpy(&len, bytes.data() + pos + sizeof(index), sizeof(len));
+      pos += 2 * sizeof(uint32_t);
+      if (bytes.size() - pos < len)
+        break; // a branch died mid-write
+      if (index < scenarios)
+        out[index] = bytes.substr(pos, len);
+      pos += len;
+    }
+    return out;
+  }
+};
+#endif
@@ -1,61 +1,273 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "afterhours/src/plugins/ui.h"
 #include "afterhours/src/plugins/ui/components.h"
-#include <nlohmann/json.hpp>
+#include <fmt/format.h>
 
-inline void dump_ui_tree_json(const std::string &path) {
+// UI tree dumps are written while walking the tree, straight into a small
+// output buffer, without building a document first.
+//
+// Two encodings, picked from the dump path's extension:
+//  - anything else: compact JSON, {"root": {id, name, rect, children}}
+//  - .uitree: binary, see UITreeBinaryWriter
+// scripts/ui_tree.js reads both back into the same JSON shape.
+enum struct UITreeFormat { Json, Binary };
+
+inline UITreeFormat ui_tree_format_for_path(std::string_view path) {
+  constexpr std::string_view ext = ".uitree";
+  if (path.size() >= ext.size() &&
+      path.substr(path.size() - ext.size()) == ext)
+    return UITreeFormat::Binary;
+  return UITreeFormat::Json;
+}
+
+// Buffers output and hands it to the stream in large chunks
+struct UITreeSink {
+  std::ostream &out;
+  fmt::memory_buffer buf;
+
+  explicit UITreeSink(std::ostream &o) : out(o) {}
+  ~UITreeSink() { flush(); }
+
+  void maybe_flush() {
+    if (buf.size() >= 64 * 1024)
+      flush();
+  }
+  void flush() {
+    out.write(buf.data(), (std::streamsize)buf.size());
+    buf.clear();
+  }
+  void put(char c) { buf.push_back(c); }
+  void put(std::string_view s) { buf.append(s.data(), s.data() + s.size()); }
+};
+
+// Little endian primitives shared by the binary tree and trace formats
+inline void put_varint(UITreeSink &sink, uint64_t v) {
+  while (v >= 0x80) {
+    sink.put((char)((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  sink.put((char)v);
+}
+
+inline void put_zigzag(UITreeSink &sink, int64_t v) {
+  put_varint(sink, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+inline void put_f32(UITreeSink &sink, float f) {
+  char bytes[sizeof(float)];
+  std::memcpy(bytes, &f, sizeof(float));
+  sink.put(std::string_view(bytes, sizeof(bytes)));
+}
+
+// Writes each distinct name once: a reference of 0 is followed by the
+// length-prefixed bytes, k > 0 points at the k-th name written before.
+// The table belongs to one writer and owns its keys, since a trace outlives
+// the entities whose names it has seen; a name is copied only the first
+// time it is written, and lookups take a string_view.
+struct UITreeNameTable {
+  struct Hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+  std::unordered_map<std::string, uint32_t, Hash, std::equal_to<>> refs;
+
+  void put(UITreeSink &sink, std::string_view name) {
+    if (auto it = refs.find(name); it != refs.end()) {
+      put_varint(sink, it->second);
+      return;
+    }
+    put_varint(sink, 0);
+    put_varint(sink, name.size());
+    sink.put(name);
+    refs.emplace(std::string(name), (uint32_t)refs.size() + 1);
+  }
+};
+
+struct UITreeRect {
+  float x = 0.f;
+  float y = 0.f;
+  float w = 0.f;
+  float h = 0.f;
+};
+
+struct UITreeJsonWriter {
+  UITreeSink &sink;
+
+  void begin() { sink.put("{\"root\":"); }
+  void end() { sink.put('}'); }
+
+  void begin_node(afterhours::EntityID id, std::string_view name,
+                  const UITreeRect &r, size_t) {
+    fmt::format_to(std::back_inserter(sink.buf), "{{\"id\":{},\"name\":", id);
+    put_string(name);
+    sink.put(",\"rect\":{\"x\":");
+    put_number(r.x);
+    sink.put(",\"y\":");
+    put_number(r.y);
+    sink.put(",\"w\":");
+    put_number(r.w);
+    sink.put(",\"h\":");
+    put_number(r.h);
+    sink.put("},\"children\":[");
+  }
+  void between_children() { sink.put(','); }
+  void end_node() {
+    sink.put("]}");
+    sink.maybe_flush();
+  }
+
+  // JSON has no nan/inf; write null like nlohmann::json did
+  void put_number(float f) {
+    if (std::isfinite(f))
+      fmt::format_to(std::back_inserter(sink.buf), "{}", f);
+    else
+      sink.put("null");
+  }
+
+  void put_string(std::string_view s) {
+    sink.put('"');
+    for (char c : s) {
+      switch (c) {
+      case '"':
+        sink.put("\\\"");
+        break;
+      case '\\':
+        sink.put("\\\\");
+        break;
+      case '\n':
+        sink.put("\\n");
+        break;
+      default:
+        if ((unsigned char)c < 0x20)
+          fmt::format_to(std::back_inserter(sink.buf), "\\u{:04x}",
+                         (unsigned)c);
+        else
+          sink.put(c);
+      }
+    }
+    sink.put('"');
+  }
+};
+
+// Binary layout (little endian, varints are LEB128):
+//   "AHUT" u8 version
+//   node := varint zigzag(id)
+//           name                 see UITreeNameTable
+//           f32 x, f32 y, f32 w, f32 h
+//           varint child_count, then child_count nodes
+// Names repeat a lot (every button row, every list item) so each distinct
+// name is only written once per file.
+struct UITreeBinaryWriter {
+  static constexpr char kMagic[4] = {'A', 'H', 'U', 'T'};
+  static constexpr uint8_t kVersion = 1;
+
+  UITreeSink &sink;
+  UITreeNameTable names;
+
+  void begin() {
+    sink.put(std::string_view(kMagic, sizeof(kMagic)));
+    sink.put((char)kVersion);
+  }
+  void end() {}
+
+  void begin_node(afterhours::EntityID id, std::string_view name,
+                  const UITreeRect &r, size_t child_count) {
+    put_zigzag(sink, id);
+    names.put(sink, name);
+    put_f32(sink, r.x);
+    put_f32(sink, r.y);
+    put_f32(sink, r.w);
+    put_f32(sink, r.h);
+    put_varint(sink, child_count);
+  }
+  void between_children() {}
+  void end_node() { sink.maybe_flush(); }
+};
+
+// Depth-first walk from the AutoLayoutRoot with an explicit stack, emitting
+// each node as soon as it is visited
+template <typename Writer> inline void write_ui_tree(Writer &writer) {
   using namespace afterhours::ui;
   afterhours::Entity &root_ent = afterhours::EntityQuery()
                                      .whereHasComponent<AutoLayoutRoot>()
                                      .gen_first_enforce();
 
-  std::function<nlohmann::json(afterhours::EntityID)> rec_json;
-  rec_json = [&](afterhours::EntityID id) -> nlohmann::json {
-    nlohmann::json node;
-    node["id"] = id;
+  struct Frame {
+    const UIComponent *cmp;
+    size_t next_child;
+  };
+  static thread_local std::vector<Frame> stack;
+  stack.clear();
 
+  auto visit = [&](afterhours::EntityID id) {
     auto opt = afterhours::EntityHelper::getEntityForID(id);
     if (!opt) {
-      node["name"] = "missing";
-      node["rect"] = { {"x", 0}, {"y", 0}, {"w", 0}, {"h", 0} };
-      node["children"] = nlohmann::json::array();
-      return node;
+      writer.begin_node(id, "missing", UITreeRect{}, 0);
+      writer.end_node();
+      return;
     }
-
     afterhours::Entity &e = opt.asE();
     if (!e.has<UIComponent>()) {
-      node["name"] = "no_uicmp";
-      node["rect"] = { {"x", 0}, {"y", 0}, {"w", 0}, {"h", 0} };
-      node["children"] = nlohmann::json::array();
-      return node;
+      writer.begin_node(id, "no_uicmp", UITreeRect{}, 0);
+      writer.end_node();
+      return;
     }
-
-    UIComponent &cmp = e.get<UIComponent>();
-    RectangleType r = cmp.rect();
-    const std::string name = e.has<UIComponentDebug>()
-                                 ? e.get<UIComponentDebug>().name()
-                                 : std::string("unknown");
-
-    node["name"] = name;
-    node["rect"] = { {"x", r.x}, {"y", r.y}, {"w", r.width}, {"h", r.height} };
-
-    nlohmann::json children = nlohmann::json::array();
-    for (size_t i = 0; i < cmp.children.size(); ++i) {
-      children.push_back(rec_json(cmp.children[i]));
+    const UIComponent &cmp = e.get<UIComponent>();
+    const RectangleType r = cmp.rect();
+    const UITreeRect rect{r.x, r.y, r.width, r.height};
+    if (e.has<UIComponentDebug>()) {
+      const auto &name = e.get<UIComponentDebug>().name();
+      writer.begin_node(id, name, rect, cmp.children.size());
+    } else {
+      writer.begin_node(id, "unknown", rect, cmp.children.size());
     }
-    node["children"] = std::move(children);
-    return node;
+    stack.push_back(Frame{&cmp, 0});
   };
 
-  nlohmann::json root;
-  root["root"] = rec_json(root_ent.id);
+  writer.begin();
+  visit(root_ent.id);
+  while (!stack.empty()) {
+    Frame &top = stack.back();
+    if (top.next_child == top.cmp->children.size()) {
+      stack.pop_back();
+      writer.end_node();
+      continue;
+    }
+    if (top.next_child > 0)
+      writer.between_children();
+    const afterhours::EntityID child = top.cmp->children[top.next_child++];
+    visit(child);
+  }
+  writer.end();
+}
+
+inline void write_ui_tree(std::ostream &out, UITreeFormat format) {
+  UITreeSink sink(out);
+  if (format == UITreeFormat::Binary) {
+    UITreeBinaryWriter writer{.sink = sink};
+    write_ui_tree(writer);
+  } else {
+    UITreeJsonWriter writer{.sink = sink};
+    write_ui_tree(writer);
+  }
+}
 
-  std::ofstream out(path);
+inline void dump_ui_tree_json(const std::string &path) {
+  std::ofstream out(path, std::ios::binary);
   if (out) {
-    out << root.dump(2);
+    write_ui_tree(out, ui_tree_format_for_path(path));
   }
 }
@@ -5,6 +5,8 @@
 #include "afterhours/src/plugins/ui/context.h"
 #include "afterhours/src/system.h"
 #include "ui_demo/input_mapping.h"
+#include "ui_demo/playback.h"
+#include "ui_demo/router.h"
 
 namespace ui_demo {
 namespace examples {
@@ -12,7 +14,15 @@ namespace examples {
 using UIX = afterhours::ui::UIContext<InputAction>;
 
 // Declarations for example entrypoints
-void render_single_button(UIX &context, afterhours::Entity &panel);
+// `parked`: emitted hidden; see render_home_page in router.cpp
+void render_single_button(UIX &context, afterhours::Entity &panel,
+                          ExampleState &state, bool parked);
+void render_stress_tree(UIX &context, afterhours::Entity &parent,
+                        const StressTreeConfig &cfg);
+void render_virtual_list(UIX &context, afterhours::Entity &parent,
+                         const VirtualListConfig &cfg);
+void render_typeahead(UIX &context, afterhours::Entity &parent,
+                      const TypeaheadConfig &cfg);
 
 } // namespace examples
 } // namespace ui_demo
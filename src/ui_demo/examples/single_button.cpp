@@ -1,5 +1,8 @@
+#include "rl.h"
+
 #include "afterhours/src/plugins/ui/immediate.h"
 #include "examples.h"
+#include "ui_demo/intern.h"
 #include "ui_demo/playback.h"
 
 using namespace afterhours;
@@ -28,17 +31,18 @@ parse_theme_usage_or_default(const std::optional<std::string> &s,
   return def;
 }
 
-void render_single_button(UIX &context, afterhours::Entity &panel) {
+void render_single_button(UIX &context, afterhours::Entity &panel,
+                          ExampleState &state, bool parked) {
   auto body = div(context, mk(panel, 1),
                   ComponentConfig()
                       .with_size(ComponentSize{children(), pixels(500.f)})
                       .with_flex_direction(FlexDirection::Row)
-                      .with_debug_name("example_body"));
+                      .with_debug_name("example_body"_interned));
 
   auto col_left = div(context, mk(body.ent(), 0),
                       ComponentConfig()
                           .with_size(ComponentSize{pixels(480.f), children()})
-                          .with_debug_name("example_col_left"));
+                          .with_debug_name("example_col_left"_interned));
 
   // Determine variants from playback config if present
   bool has_label = true;
@@ -54,12 +58,14 @@ void render_single_button(UIX &context, afterhours::Entity &panel) {
         parse_theme_usage_or_default(cfg.button_color, Theme::Usage::Primary);
   }
 
-  auto btn_cfg = ComponentConfig()
-                     .with_label(has_label ? "Action" : "")
-                     .with_size(ComponentSize{pixels(220.f), pixels(50.f)})
-                     .with_color_usage(usage)
-                     .with_disabled(disabled)
-                     .with_debug_name("example_action_button");
+  auto btn_cfg =
+      ComponentConfig()
+          .with_label(has_label ? "Action"_interned : InternedString())
+          .with_size(ComponentSize{pixels(220.f), pixels(50.f)})
+          .with_color_usage(usage)
+          .with_disabled(disabled)
+          .with_skip_tabbing(parked)
+          .with_debug_name("example_action_button"_interned);
 
   button(context, mk(col_left.ent(), 0), btn_cfg);
 
@@ -67,19 +73,26 @@ void render_single_button(UIX &context, afterhours::Entity &panel) {
   auto col_right = div(context, mk(body.ent(), 1),
                        ComponentConfig()
                            .with_size(ComponentSize{pixels(480.f), children()})
-                           .with_debug_name("example_col_right"));
+                           .with_debug_name("example_col_right"_interned));
 
-  static bool enabled_checkbox = true;
-  checkbox(context, mk(col_left.ent(), 1), enabled_checkbox,
+  bool enabled = state.enabled_checkbox;
+  checkbox(context, mk(col_left.ent(), 1), enabled,
            ComponentConfig()
-               .with_label("example_enabled_checkbox")
-               .with_debug_name("example_enabled_checkbox"));
+               .with_label("example_enabled_checkbox"_interned)
+               .with_skip_tabbing(parked)
+               .with_debug_name("example_enabled_checkbox"_interned));
 
-  static float strength = 0.5f;
+  float strength = state.strength;
   slider(context, mk(col_right.ent(), 0), strength,
          ComponentConfig()
-             .with_label("example_strength_slider")
-             .with_debug_name("example_strength_slider"));
+             .with_label("example_strength_slider"_interned)
+             .with_skip_tabbing(parked)
+             .with_debug_name("example_strength_slider"_interned));
+
+  if (!parked) {
+    state.enabled_checkbox = enabled;
+    state.strength = strength;
+  }
 }
 
 } // namespace examples
@@ -0,0 +1,127 @@
+#include "rl.h"
+
+#include "afterhours/src/plugins/ui/immediate.h"
+#include "examples.h"
+#include "ui_demo/playback.h"
+
+using namespace afterhours;
+using namespace afterhours::ui;
+using namespace afterhours::ui::imm;
+
+namespace ui_demo {
+namespace examples {
+
+enum struct StressSizing { Pixels, Percent, Children };
+
+static StressSizing stress_sizing_for(const std::string &mode, int index) {
+  if (mode == "pixels")
+    return StressSizing::Pixels;
+  if (mode == "percent")
+    return StressSizing::Percent;
+  if (mode == "children")
+    return StressSizing::Children;
+  // "mixed": rotate so every level sees all three
+  return (StressSizing)(index % 3);
+}
+
+// One generated node. The configs only depend on the StressTreeConfig, so
+// they are built once and reused every frame until the config changes.
+struct StressNodePlan {
+  int parent; // index into the plan
+  int slot;
+  bool button;
+  ComponentConfig config;
+};
+
+static bool same_stress_config(const StressTreeConfig &a,
+                               const StressTreeConfig &b) {
+  return a.nodes == b.nodes && a.fanout == b.fanout && a.sizing == b.sizing &&
+         a.button_every == b.button_every;
+}
+
+// Nodes are laid out as a complete `fanout`-ary tree in breadth-first order
+// (node i's parent is (i - 1) / fanout), so fanout 1 is a chain as deep as
+// the node count and a fanout >= nodes is one flat row. Even depths flex as
+// rows and odd depths as columns; percent sizing splits the parent's main
+// axis evenly. Leaves can't size to children, so they fall back to pixels.
+static void plan_stress_tree(const StressTreeConfig &cfg,
+                             std::vector<StressNodePlan> &plan) {
+  plan.clear();
+  plan.reserve((size_t)std::max(1, cfg.nodes));
+  std::vector<int> depths;
+  depths.reserve(plan.capacity());
+  plan.push_back(StressNodePlan{
+      -1, 0, false,
+      ComponentConfig()
+          .with_size(ComponentSize{percent(1.f), percent(1.f)})
+          .with_flex_direction(FlexDirection::Row)
+          .with_debug_name("stress_root")});
+  depths.push_back(0);
+
+  const int fanout = std::max(1, cfg.fanout);
+  const int siblings = std::min(fanout, std::max(1, cfg.nodes - 1));
+  const float share = 1.f / (float)siblings;
+  int leaf_count = 0;
+  for (int i = 1; i < cfg.nodes; i++) {
+    const int parent = (i - 1) / fanout;
+    const int slot = (i - 1) % fanout;
+    const int depth = depths[(size_t)parent] + 1;
+    const bool leaf = (long long)i * fanout + 1 >= cfg.nodes;
+    const bool parent_is_row = depths[(size_t)parent] % 2 == 0;
+
+    StressSizing sizing = stress_sizing_for(cfg.sizing, i);
+    if (leaf && sizing == StressSizing::Children)
+      sizing = StressSizing::Pixels;
+    ComponentSize size{pixels(12.f), pixels(12.f)};
+    if (sizing == StressSizing::Percent) {
+      size = parent_is_row ? ComponentSize{percent(share), percent(1.f)}
+                           : ComponentSize{percent(1.f), percent(share)};
+    } else if (sizing == StressSizing::Children) {
+      size = ComponentSize{children(), children()};
+    }
+
+    ComponentConfig config =
+        ComponentConfig()
+            .with_size(size)
+            .with_flex_direction(depth % 2 == 0 ? FlexDirection::Row
+                                                : FlexDirection::Column);
+    const bool button =
+        leaf && cfg.button_every > 0 && leaf_count++ % cfg.button_every == 0;
+    if (button)
+      config.with_label("b").with_debug_name("stress_button");
+    else
+      config.with_debug_name("stress_node");
+    plan.push_back(StressNodePlan{parent, slot, button, std::move(config)});
+    depths.push_back(depth);
+  }
+}
+
+// Generated tree for profiling layout, input and render at scale
+void render_stress_tree(UIX &context, afterhours::Entity &parent,
+                        const StressTreeConfig &cfg) {
+  // Reused across frames; rebuilt only when the config changes
+  static std::vector<StressNodePlan> plan;
+  static std::optional<StressTreeConfig> planned_for;
+  if (!planned_for || !same_stress_config(*planned_for, cfg)) {
+    plan_stress_tree(cfg, plan);
+    planned_for = cfg;
+  }
+  static std::vector<afterhours::Entity *> ents;
+  ents.clear();
+  ents.reserve(plan.size());
+
+  ents.push_back(&div(context, mk(parent, 0), plan.front().config).ent());
+  for (size_t i = 1; i < plan.size(); i++) {
+    const StressNodePlan &node = plan[i];
+    afterhours::Entity &p = *ents[(size_t)node.parent];
+    if (node.button) {
+      auto btn = button(context, mk(p, node.slot), node.config);
+      ents.push_back(&btn.ent());
+      continue;
+    }
+    ents.push_back(&div(context, mk(p, node.slot), node.config).ent());
+  }
+}
+
+} // namespace examples
+} // namespace ui_demo
@@ -0,0 +1,169 @@
+#include "rl.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "afterhours/src/plugins/ui/immediate.h"
+#include "examples.h"
+#include "log.h"
+#include "ui_demo/indexed_options.h"
+#include "ui_demo/intern.h"
+#include "ui_demo/playback.h"
+
+using namespace afterhours;
+using namespace afterhours::ui;
+using namespace afterhours::ui::imm;
+
+namespace ui_demo {
+namespace examples {
+
+struct TypeaheadState : public afterhours::BaseComponent {
+  bool loaded = false;
+  // What the provider indexes; "Add 1000" appends and hands it over again
+  std::vector<std::string> options;
+  // Labels are formatted again only when what they show changes
+  std::string header;
+  size_t header_matches = SIZE_MAX;
+  size_t header_page = SIZE_MAX;
+  std::string header_query;
+  std::string selected;
+  uint32_t selected_id = UINT32_MAX;
+};
+
+// Asset / user style ids, so short queries hit many and long ones few
+static void append_options(std::vector<std::string> &options, size_t n) {
+  static constexpr const char *kKinds[] = {"texture", "mesh", "sound",
+                                           "user"};
+  const size_t first = options.size();
+  options.reserve(first + n);
+  for (size_t i = first; i < first + n; i++)
+    options.push_back(fmt::format("{}_{:06}", kKinds[i % 4], i));
+}
+
+// Keyboard text entry; playback sets the query through [typeahead] instead
+static bool edit_query(std::string &query) {
+  bool changed = false;
+  for (int c = raylib::GetCharPressed(); c > 0; c = raylib::GetCharPressed()) {
+    if (c >= 32 && c < 127) {
+      query.push_back((char)c);
+      changed = true;
+    }
+  }
+  if (raylib::IsKeyPressed(raylib::KEY_BACKSPACE) && !query.empty()) {
+    query.pop_back();
+    changed = true;
+  }
+  return changed;
+}
+
+// Searchable dropdown over cfg.options generated ids, see
+// ui_demo/indexed_options.h
+void render_typeahead(UIX &context, afterhours::Entity &parent,
+                      const TypeaheadConfig &cfg) {
+  auto screen = div(context, mk(parent, 0),
+                    ComponentConfig()
+                        .with_size(ComponentSize{percent(1.f), percent(1.f)})
+                        .with_flex_direction(FlexDirection::Column)
+                        .with_debug_name("typeahead_screen"_interned));
+  Entity &ent = screen.ent();
+  IndexedOptionsProvider &provider =
+      ent.addComponentIfMissing<IndexedOptionsProvider>();
+  TypeaheadState &state = ent.addComponentIfMissing<TypeaheadState>();
+  if (!state.loaded) {
+    state.loaded = true;
+    append_options(state.options, (size_t)std::max(0, cfg.options));
+    provider.page_size = (size_t)std::max(1, cfg.page_size);
+    provider.set_options(state.options);
+    provider.set_query(cfg.query);
+  }
+
+  std::string query = provider.query();
+  if (edit_query(query))
+    provider.set_query(query);
+
+  if (provider.matches() != state.header_matches ||
+      provider.page() != state.header_page ||
+      provider.query() != state.header_query) {
+    state.header_matches = provider.matches();
+    state.header_page = provider.page();
+    state.header_query = provider.query();
+    state.header = fmt::format("Search: {}_  ({} matches, page {}/{})",
+                               provider.query(), provider.matches(),
+                               provider.page() + 1, provider.pages());
+  }
+  div(context, mk(ent, 0),
+      ComponentConfig()
+          .with_label(state.header)
+          .with_size(ComponentSize{percent(1.f), pixels(50.f)})
+          .with_color_usage(Theme::Usage::Primary)
+          .with_skip_tabbing(true)
+          .with_debug_name("typeahead_header"_interned));
+
+  auto controls = div(context, mk(ent, 1),
+                      ComponentConfig()
+                          .with_size(ComponentSize{percent(1.f), children()})
+                          .with_flex_direction(FlexDirection::Row)
+                          .with_debug_name("typeahead_controls"_interned));
+  if (button(context, mk(controls.ent(), 0),
+             ComponentConfig()
+                 .with_label("Prev"_interned)
+                 .with_size(ComponentSize{pixels(160.f), pixels(50.f)})
+                 .with_debug_name("typeahead_prev"_interned)))
+    provider.prev_page();
+  if (button(context, mk(controls.ent(), 1),
+             ComponentConfig()
+                 .with_label("Next"_interned)
+                 .with_size(ComponentSize{pixels(160.f), pixels(50.f)})
+                 .with_debug_name("typeahead_next"_interned)))
+    provider.next_page();
+  // Changes the data under the dropdown; only the new options get indexed
+  if (button(context, mk(controls.ent(), 2),
+             ComponentConfig()
+                 .with_label("Add 1000"_interned)
+                 .with_size(ComponentSize{pixels(160.f), pixels(50.f)})
+                 .with_debug_name("typeahead_add"_interned))) {
+    append_options(state.options, 1000);
+    provider.set_options(state.options);
+  }
+
+  if (provider.page_labels().empty()) {
+    div(context, mk(ent, 2),
+        ComponentConfig()
+            .with_label("No matches"_interned)
+            .with_size(ComponentSize{pixels(300.f), pixels(50.f)})
+            .with_skip_tabbing(true)
+            .with_debug_name("typeahead_empty"_interned));
+  } else {
+    // A selection filtered off the page stays selected (and shown below);
+    // the dropdown falls back to showing the first match, but only a pick
+    // changes what is selected
+    size_t on_page = provider.selected_on_page().value_or(0);
+    if (dropdown(context, mk(ent, 3), provider.page_labels(), on_page,
+                 ComponentConfig()
+                     .with_size(ComponentSize{pixels(300.f), pixels(50.f)})
+                     .with_debug_name("typeahead_dropdown"_interned)))
+      provider.on_data_changed(on_page);
+  }
+
+  const uint32_t selected_id = provider.selected().value_or(UINT32_MAX);
+  if (state.selected.empty() || selected_id != state.selected_id) {
+    state.selected_id = selected_id;
+    state.selected = fmt::format(
+        "Selected: {}", selected_id == UINT32_MAX
+                            ? std::string_view()
+                            : std::string_view(
+                                  provider.index().text(selected_id)));
+  }
+  div(context, mk(ent, 4),
+      ComponentConfig()
+          .with_label(state.selected)
+          .with_size(ComponentSize{percent(1.f), pixels(50.f)})
+          .with_skip_tabbing(true)
+          .with_debug_name("typeahead_selected"_interned));
+}
+
+} // namespace examples
+} // namespace ui_demo
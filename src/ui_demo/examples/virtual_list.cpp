@@ -0,0 +1,133 @@
+#include "rl.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "afterhours/src/plugins/input_system.h"
+#include "afterhours/src/plugins/ui/immediate.h"
+#include "examples.h"
+#include "log.h"
+#include "ui_demo/intern.h"
+#include "ui_demo/playback.h"
+#include "ui_demo/virtual_list.h"
+
+using namespace afterhours;
+using namespace afterhours::ui;
+using namespace afterhours::ui::imm;
+
+namespace ui_demo {
+namespace examples {
+
+// Row labels are kept per slot and only formatted again when a different row
+// lands in it, so scrolling doesn't format every label in view every frame.
+// Direct mapped on row % kLabelSlots, which is more than fit on screen.
+struct VirtualListState : public afterhours::BaseComponent {
+  static constexpr size_t kLabelSlots = 256;
+
+  size_t first_row = 0;
+  VirtualRange shown;
+  std::string header;
+  std::vector<std::pair<size_t, std::string>> labels =
+      std::vector<std::pair<size_t, std::string>>(kLabelSlots,
+                                                  {SIZE_MAX, std::string()});
+
+  const std::string &label_for(size_t row) {
+    auto &[cached_row, label] = labels[row % kLabelSlots];
+    if (cached_row != row) {
+      cached_row = row;
+      label = fmt::format("#{}", row);
+    }
+    return label;
+  }
+};
+
+static void scroll_from_input(VirtualListState &state, size_t step) {
+  auto pic = input::get_input_collector<InputAction>();
+  if (!pic.has_value())
+    return;
+  for (const auto &done : pic.inputs_pressed()) {
+    if (done.action == InputAction::ValueDown)
+      state.first_row += step;
+    else if (done.action == InputAction::ValueUp)
+      state.first_row -= std::min(state.first_row, step);
+  }
+}
+
+// Log / inventory style browser over cfg.rows rows, see ui_demo/virtual_list.h
+void render_virtual_list(UIX &context, afterhours::Entity &parent,
+                         const VirtualListConfig &cfg) {
+  auto screen = div(context, mk(parent, 0),
+                    ComponentConfig()
+                        .with_size(ComponentSize{percent(1.f), percent(1.f)})
+                        .with_flex_direction(FlexDirection::Column)
+                        .with_debug_name("virtual_list_screen"_interned));
+  VirtualListState &state =
+      screen.ent().addComponentIfMissing<VirtualListState>();
+  scroll_from_input(state, (size_t)std::max(1, cfg.scroll_step));
+
+  const size_t rows = (size_t)std::max<int64_t>(0, cfg.rows);
+  const size_t columns = (size_t)std::max(1, cfg.columns);
+  const float row_height = std::max(1.f, cfg.row_height);
+
+  // Shows last frame's range; the list below is what decides it
+  div(context, mk(screen.ent(), 0),
+      ComponentConfig()
+          .with_label(state.header)
+          .with_size(ComponentSize{percent(1.f), pixels(50.f)})
+          .with_color_usage(Theme::Usage::Primary)
+          .with_skip_tabbing(true)
+          .with_debug_name("virtual_list_header"_interned));
+
+  ComponentConfig list_config =
+      ComponentConfig()
+          .with_size(ComponentSize{percent(1.f), pixels(600.f)})
+          .with_debug_name("virtual_list"_interned);
+  VirtualRange range;
+  if (columns > 1) {
+    const float cell_width = 1.f / (float)columns;
+    range = virtual_grid(
+        context, mk(screen.ent(), 1), rows, columns, row_height,
+        state.first_row,
+        [&](EntityParent ep, size_t index) {
+          div(context, ep,
+              ComponentConfig()
+                  .with_label(state.label_for(index))
+                  .with_size(ComponentSize{percent(cell_width),
+                                           pixels(row_height)})
+                  .with_skip_tabbing(true)
+                  .with_debug_name("virtual_list_cell"_interned));
+        },
+        std::move(list_config));
+  } else {
+    range = virtual_list(
+        context, mk(screen.ent(), 1), rows, row_height, state.first_row,
+        [&](EntityParent ep, size_t row) {
+          div(context, ep,
+              ComponentConfig()
+                  .with_label(state.label_for(row))
+                  .with_size(ComponentSize{percent(1.f), pixels(row_height)})
+                  .with_color_usage(row % 2 ? Theme::Usage::Secondary
+                                            : Theme::Usage::Background)
+                  .with_skip_tabbing(true)
+                  .with_debug_name("virtual_list_row"_interned));
+        },
+        std::move(list_config));
+  }
+
+  if (range.first != state.shown.first || range.end != state.shown.end ||
+      state.header.empty()) {
+    state.shown = range;
+    const size_t first_item = range.first * columns;
+    const size_t end_item = std::min(rows, range.end * columns);
+    state.header = end_item > first_item
+                       ? fmt::format("{}-{} of {}", first_item, end_item - 1,
+                                     rows)
+                       : fmt::format("{} rows", rows);
+  }
+}
+
+} // namespace examples
+} // namespace ui_demo
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "ui_demo/dump.h"
+#include <nlohmann/json.hpp>
+
+// In-process version of run_actions.js matchNode, for --expect=<file>.
+//
+// The expected file is the scenario's {"root": ...} subset tree. It is matched
+// directly against the live UIComponent tree, with the same rules and the same
+// error messages as the runner:
+//  - a node's name must match if the expected node has one
+//  - a rect, if given, must match within UI_POS_TOL (default 0.5)
+//  - expected children must appear among the actual children, in order, by
+//    name; extra actual nodes are ignored
+struct ExpectMismatch {
+  std::string kind; // name | rect | missing_child
+  std::string path;
+  std::string message;
+};
+
+struct ExpectResult {
+  bool ok = true;
+  std::vector<ExpectMismatch> errors;
+
+  nlohmann::json to_json() const {
+    nlohmann::json errs = nlohmann::json::array();
+    for (const ExpectMismatch &m : errors) {
+      errs.push_back(
+          {{"kind", m.kind}, {"path", m.path}, {"message", m.message}});
+    }
+    return {{"ok", ok}, {"errors", std::move(errs)}};
+  }
+};
+
+struct UITreeExpectation {
+  nlohmann::json expected_root;
+  float tolerance = 0.5f;
+
+  static std::optional<UITreeExpectation> load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in)
+      return std::nullopt;
+    try {
+      nlohmann::json doc = nlohmann::json::parse(in);
+      if (!doc.contains("root") || !doc["root"].is_object())
+        return std::nullopt;
+      UITreeExpectation e;
+      e.expected_root = std::move(doc["root"]);
+      if (const char *tol = std::getenv("UI_POS_TOL"))
+        e.tolerance = std::strtof(tol, nullptr);
+      return e;
+    } catch (const std::exception &ex) {
+      log_warn("Failed parsing expected tree {}: {}", path, ex.what());
+      return std::nullopt;
+    }
+  }
+
+  ExpectResult check() const {
+    using namespace afterhours::ui;
+    afterhours::Entity &root_ent = afterhours::EntityQuery()
+                                       .whereHasComponent<AutoLayoutRoot>()
+                                       .gen_first_enforce();
+    ExpectResult result;
+    result.ok = match(expected_root, root_ent.id, "root", result.errors);
+    return result;
+  }
+
+private:
+  // What the dump would write for this entity
+  struct LiveNode {
+    std::string_view name;
+    UITreeRect rect;
+    const std::vector<afterhours::EntityID> *children = nullptr;
+  };
+
+  static LiveNode live_node(afterhours::EntityID id) {
+    using namespace afterhours::ui;
+    auto opt = afterhours::EntityHelper::getEntityForID(id);
+    if (!opt)
+      return LiveNode{.name = "missing"};
+    afterhours::Entity &e = opt.asE();
+    if (!e.has<UIComponent>())
+      return LiveNode{.name = "no_uicmp"};
+    const UIComponent &cmp = e.get<UIComponent>();
+    const RectangleType r = cmp.rect();
+    return LiveNode{.name = e.has<UIComponentDebug>()
+                                ? std::string_view(
+                                      e.get<UIComponentDebug>().name())
+                                : std::string_view("unknown"),
+                    .rect = UITreeRect{r.x, r.y, r.width, r.height},
+                    .children = &cmp.children};
+  }
+
+  bool approx_equal(const nlohmann::json &er, const char *key,
+                    float actual) const {
+    const float want =
+        er.contains(key) && er[key].is_number() ? er[key].get<float>() : 0.f;
+    return std::fabs(want - actual) <= tolerance;
+  }
+
+  bool match(const nlohmann::json &expected, afterhours::EntityID id,
+             const std::string &path,
+             std::vector<ExpectMismatch> &errors) const {
+    const LiveNode actual = live_node(id);
+
+    if (expected.contains("name")) {
+      const std::string &want =
+          expected["name"].get_ref<const std::string &>();
+      if (actual.name != want) {
+        errors.push_back({"name", path,
+                          fmt::format("name mismatch at {}: expected '{}', "
+                                      "got '{}'",
+                                      path, want, actual.name)});
+        return false;
+      }
+    }
+
+    if (expected.contains("rect")) {
+      const nlohmann::json &er = expected["rect"];
+      const UITreeRect &ar = actual.rect;
+      if (!approx_equal(er, "x", ar.x) || !approx_equal(er, "y", ar.y) ||
+          !approx_equal(er, "w", ar.w) || !approx_equal(er, "h", ar.h)) {
+        const nlohmann::json got = {
+            {"x", ar.x}, {"y", ar.y}, {"w", ar.w}, {"h", ar.h}};
+        errors.push_back(
+            {"rect", path,
+             fmt::format("rect mismatch at {}: expected {}, got {}", path,
+                         er.dump(), got.dump())});
+        return false;
+      }
+    }
+
+    if (!expected.contains("children"))
+      return true;
+    static const std::vector<afterhours::EntityID> kNoChildren;
+    const std::vector<afterhours::EntityID> &act_children =
+        actual.children ? *actual.children : kNoChildren;
+
+    size_t ai = 0;
+    for (const nlohmann::json &exp_child : expected["children"]) {
+      const bool has_name = exp_child.contains("name");
+      const std::string_view want =
+          has_name ? std::string_view(
+                         exp_child["name"].get_ref<const std::string &>())
+                   : std::string_view();
+      std::optional<size_t> match_idx;
+      for (; ai < act_children.size(); ai++) {
+        if (!has_name || live_node(act_children[ai]).name == want) {
+          match_idx = ai++;
+          break;
+        }
+      }
+      if (!match_idx) {
+        errors.push_back(
+            {"missing_child", path,
+             fmt::format("missing child at {}: '{}'", path,
+                         has_name ? want : std::string_view("(unnamed)"))});
+        return false;
+      }
+      const std::string child_path =
+          has_name ? fmt::format("{}/{}", path, want)
+                   : fmt::format("{}/{}", path, *match_idx);
+      if (!match(exp_child, act_children[*match_idx], child_path, errors))
+        return false;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Ensure Raylib-backed types/macros are defined before any afterhours includes
+#include "rl.h"
+
+#include "afterhours/src/system.h"
+#include "ui_demo/option_index.h"
+
+// Dropdown option provider for huge option sets, filtered by a typed query.
+//
+// The typeahead example hands page_labels() to imm::dropdown every frame, so
+// the dropdown only ever holds the current page of matches and copies
+// page_size strings, never the whole set. Filtering goes through an
+// OptionIndex, and set_options() only re-indexes options that changed.
+// on_data_changed(i) is the write-back for a pick from the page.
+struct IndexedOptionsProvider : public afterhours::BaseComponent {
+  size_t page_size = 10;
+
+  void set_options(const std::vector<std::string> &options) {
+    index_.assign(options);
+    if (selected_ && *selected_ >= index_.size())
+      selected_.reset();
+    refresh();
+  }
+
+  void set_query(std::string_view query) {
+    if (query == query_)
+      return;
+    query_ = std::string(query);
+    page_ = 0;
+    refresh();
+  }
+  const std::string &query() const { return query_; }
+
+  void next_page() {
+    if ((page_ + 1) * page_size < matches_) {
+      page_++;
+      refresh();
+    }
+  }
+  void prev_page() {
+    if (page_ > 0) {
+      page_--;
+      refresh();
+    }
+  }
+  size_t page() const { return page_; }
+  size_t pages() const {
+    return std::max<size_t>(1, (matches_ + page_size - 1) / page_size);
+  }
+  size_t matches() const { return matches_; }
+
+  // Options on the current page, and their ids in the full set
+  const std::vector<std::string> &page_labels() const { return labels_; }
+  const std::vector<uint32_t> &page_ids() const { return ids_; }
+
+  // Selection as an option id, and as an index into the page
+  std::optional<uint32_t> selected() const { return selected_; }
+  std::optional<size_t> selected_on_page() const {
+    if (!selected_)
+      return std::nullopt;
+    auto it = std::find(ids_.begin(), ids_.end(), *selected_);
+    if (it == ids_.end())
+      return std::nullopt;
+    return (size_t)(it - ids_.begin());
+  }
+
+  void on_data_changed(size_t index) {
+    if (index < ids_.size())
+      selected_ = ids_[index];
+  }
+
+  const OptionIndex &index() const { return index_; }
+
+private:
+  OptionIndex index_;
+  std::string query_;
+  size_t page_ = 0;
+  size_t matches_ = 0;
+  std::optional<uint32_t> selected_;
+  std::vector<uint32_t> ids_;
+  std::vector<std::string> labels_;
+
+  void refresh() {
+    matches_ = index_.find(query_, page_ * page_size, page_size, ids_);
+    if (page_ > 0 && page_ * page_size >= matches_) {
+      page_ = pages() - 1;
+      matches_ = index_.find(query_, page_ * page_size, page_size, ids_);
+    }
+    labels_.resize(ids_.size());
+    for (size_t i = 0; i < ids_.size(); i++)
+      labels_[i] = index_.text(ids_[i]);
+  }
+};
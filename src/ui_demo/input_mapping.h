@@ -14,6 +14,8 @@ enum class InputAction {
   WidgetPress,
   ValueDown,
   ValueUp,
+  // Opens or closes the examples overlay wherever focus is
+  ToggleExamples,
 };
 
 inline auto get_mapping() {
@@ -25,5 +27,6 @@ inline auto get_mapping() {
   mapping[InputAction::ValueUp] = input::ValidInputs{raylib::KEY_UP};
   mapping[InputAction::ValueDown] = input::ValidInputs{raylib::KEY_DOWN};
   mapping[InputAction::WidgetMod] = input::ValidInputs{raylib::KEY_LEFT_SHIFT};
+  mapping[InputAction::ToggleExamples] = input::ValidInputs{raylib::KEY_F1};
   return mapping;
 }
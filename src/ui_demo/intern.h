@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Process-wide string interner for labels and debug names.
+//
+// Each distinct string is stored once for the life of the process, and an
+// InternedString is a pointer-sized handle to it: copying or comparing one
+// never touches the heap, and it converts to `const std::string &` so it can
+// be handed to ComponentConfig::with_label / with_debug_name without building
+// a temporary std::string from a literal every frame.
+//
+//   "example_body"_interned    interned once per call site, then free
+//   InternedString::intern(s)  one hash lookup (under a mutex)
+//
+// Handles also carry a dense id (0 is the empty string), handy as an index
+// for per-name tables. Names only known at runtime (UI tree dumps) shouldn't
+// go through here: the table is never freed.
+class InternedString {
+public:
+  InternedString() : entry_(&empty_entry()) {}
+
+  static InternedString intern(std::string_view s) {
+    if (s.empty())
+      return InternedString();
+    Table &t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    auto it = t.ids.find(s);
+    if (it != t.ids.end())
+      return InternedString(it->second);
+    // deque::emplace_back never moves existing entries
+    const uint32_t id = (uint32_t)t.entries.size() + 1;
+    const Entry &e = t.entries.emplace_back(Entry{std::string(s), id});
+    t.ids.emplace(std::string_view(e.text), &e);
+    return InternedString(&e);
+  }
+
+  const std::string &str() const { return entry_->text; }
+  std::string_view view() const { return entry_->text; }
+  operator const std::string &() const { return entry_->text; }
+  uint32_t id() const { return entry_->id; }
+  bool empty() const { return entry_->id == 0; }
+
+  friend bool operator==(InternedString a, InternedString b) {
+    return a.entry_ == b.entry_;
+  }
+
+private:
+  struct Entry {
+    std::string text;
+    uint32_t id;
+  };
+  struct Table {
+    std::mutex mutex;
+    std::deque<Entry> entries;
+    std::unordered_map<std::string_view, const Entry *> ids;
+  };
+
+  const Entry *entry_;
+
+  explicit InternedString(const Entry *e) : entry_(e) {}
+
+  static const Entry &empty_entry() {
+    static const Entry e{std::string(), 0};
+    return e;
+  }
+  static Table &table() {
+    static Table t;
+    return t;
+  }
+};
+
+template <size_t N> struct InternLiteral {
+  char chars[N];
+  constexpr InternLiteral(const char (&s)[N]) { std::copy_n(s, N, chars); }
+};
+
+// Interned on first use at each distinct literal, then a static load
+template <InternLiteral S> inline InternedString operator""_interned() {
+  static const InternedString s =
+      InternedString::intern(std::string_view(S.chars, sizeof(S.chars) - 1));
+  return s;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "afterhours/src/plugins/ui.h"
+#include "afterhours/src/plugins/ui/components.h"
+#include "log.h"
+#include "ui_demo/tree_diff.h"
+
+// Dirty tracking over the laid-out UI tree, for --layout-stats.
+//
+// After autolayout, every node is compared with what it was last frame. A
+// node is dirty when it is new, its child list changed, its rect changed, or
+// any node below it is dirty (sizing to children depends on them). Dirty is
+// what a retained layout pass would have to redo; everything else could
+// reuse last frame's rect. Counts per frame are kept for the last kRingFrames
+// frames and summarized at exit.
+struct LayoutStats {
+  static constexpr size_t kRingFrames = 4096;
+
+  struct Frame {
+    uint32_t nodes = 0;
+    uint32_t dirty = 0;   // would be laid out again
+    uint32_t moved = 0;   // rect differs from last frame
+    uint32_t removed = 0; // gone since last frame
+  };
+
+  UITreeDiff diff;
+  std::vector<Frame> ring = std::vector<Frame>(kRingFrames);
+  Frame last;
+
+  // Scratch, reused across frames
+  struct Visit {
+    afterhours::EntityID id;
+    int32_t parent; // index into order, -1 for the root
+  };
+  std::vector<Visit> order;
+  std::vector<uint8_t> dirty;
+  const std::vector<afterhours::EntityID> no_children;
+
+  void record_frame() {
+    using namespace afterhours::ui;
+    diff.begin_frame();
+    Frame f;
+    order.clear();
+    afterhours::Entity &root_ent = afterhours::EntityQuery()
+                                       .whereHasComponent<AutoLayoutRoot>()
+                                       .gen_first_enforce();
+    order.push_back(Visit{root_ent.id, -1});
+    // Breadth-first, so walking `order` backwards visits children first
+    for (size_t i = 0; i < order.size(); i++) {
+      auto opt = afterhours::EntityHelper::getEntityForID(order[i].id);
+      if (!opt || !opt.asE().has<UIComponent>())
+        continue;
+      for (afterhours::EntityID child :
+           opt.asE().get<UIComponent>().children)
+        order.push_back(Visit{child, (int32_t)i});
+    }
+
+    dirty.assign(order.size(), 0);
+    for (size_t i = order.size(); i-- > 0;) {
+      const afterhours::EntityID id = order[i].id;
+      auto opt = afterhours::EntityHelper::getEntityForID(id);
+      UITreeRect rect;
+      const std::vector<afterhours::EntityID> *children = &no_children;
+      if (opt && opt.asE().has<UIComponent>()) {
+        const UIComponent &cmp = opt.asE().get<UIComponent>();
+        const RectangleType r = cmp.rect();
+        rect = UITreeRect{r.x, r.y, r.width, r.height};
+        children = &cmp.children;
+      }
+      const UITreeDiff::Change change = diff.visit(id, rect, *children);
+      if (change.added || change.moved || change.children)
+        dirty[i] = 1;
+
+      f.nodes++;
+      f.moved += change.moved ? 1 : 0;
+      if (dirty[i]) {
+        f.dirty++;
+        if (order[i].parent >= 0)
+          dirty[(size_t)order[i].parent] = 1;
+      }
+    }
+
+    f.removed = (uint32_t)diff.end_frame([](afterhours::EntityID) {});
+    last = f;
+    ring[(diff.frame - 1) % kRingFrames] = f;
+  }
+
+  void log_summary() const {
+    const size_t n = (size_t)std::min<uint64_t>(diff.frame, kRingFrames);
+    if (n == 0)
+      return;
+    uint64_t nodes_total = 0;
+    uint64_t dirty_total = 0;
+    size_t clean_frames = 0;
+    std::vector<uint32_t> dirty_counts;
+    dirty_counts.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      nodes_total += ring[i].nodes;
+      dirty_total += ring[i].dirty;
+      clean_frames += ring[i].dirty == 0 ? 1 : 0;
+      dirty_counts.push_back(ring[i].dirty);
+    }
+    std::sort(dirty_counts.begin(), dirty_counts.end());
+    const uint32_t p95 = dirty_counts[std::min(n - 1, n * 95 / 100)];
+    log_info("layout: last {} frames, {:.1f} nodes and {:.1f} dirty per frame "
+             "(p95 {}, max {}), {} frames fully clean, {:.1f}% of node "
+             "layouts reusable",
+             n, (double)nodes_total / (double)n,
+             (double)dirty_total / (double)n, p95, dirty_counts.back(),
+             clean_frames,
+             nodes_total == 0 ? 0.0
+                              : 100.0 * (double)(nodes_total - dirty_total) /
+                                    (double)nodes_total);
+  }
+};
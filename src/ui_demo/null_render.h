@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+
+#include "rl.h"
+
+// CPU-only stand-ins for the raylib pieces the UI needs when running with
+// --headless: no window, no GL context, no display server.
+namespace null_render {
+
+// Same character range and base size as raylib's built-in default font
+constexpr int kFirstGlyph = 32;
+constexpr int kGlyphCount = 224;
+constexpr int kBaseSize = 10;
+constexpr int kGlyphAdvance = 6;
+
+// Never a real GL handle; only has to be non-zero so MeasureTextEx uses the
+// glyph table below instead of bailing out on an unloaded font
+constexpr unsigned int kTextureId = 0xFFFFFFFFu;
+
+// Monospace font with only metrics filled in. Text measurement (and therefore
+// autolayout) works against it; drawing it is never attempted because the
+// render systems are not registered in headless mode.
+inline raylib::Font make_font() {
+  static std::array<raylib::GlyphInfo, kGlyphCount> glyphs{};
+  static std::array<raylib::Rectangle, kGlyphCount> recs{};
+  for (int i = 0; i < kGlyphCount; ++i) {
+    glyphs[i].value = kFirstGlyph + i;
+    glyphs[i].advanceX = kGlyphAdvance;
+    recs[i] = raylib::Rectangle{0.f, 0.f, (float)kGlyphAdvance,
+                                (float)kBaseSize};
+  }
+
+  raylib::Font font{};
+  font.baseSize = kBaseSize;
+  font.glyphCount = kGlyphCount;
+  font.texture.id = kTextureId;
+  font.texture.width = 1;
+  font.texture.height = 1;
+  font.recs = recs.data();
+  font.glyphs = glyphs.data();
+  return font;
+}
+
+} // namespace null_render
@@ -0,0 +1,140 @@
+#include "ui_demo/option_index.h"
+
+#include <algorithm>
+#include <cctype>
+
+std::string OptionIndex::lowered(std::string_view s) {
+  std::string out(s);
+  for (char &c : out)
+    c = (char)std::tolower((unsigned char)c);
+  return out;
+}
+
+// Length in the top byte, so "a", "a\0" and "\0a" never share a key
+uint32_t OptionIndex::gram_key(std::string_view gram) {
+  uint32_t key = (uint32_t)gram.size() << 24;
+  for (size_t i = 0; i < gram.size(); i++)
+    key |= (uint32_t)(unsigned char)gram[i] << (8 * (2 - i));
+  return key;
+}
+
+// Distinct grams of `lower` from min_len to max_len characters, sorted
+void OptionIndex::grams_of(std::string_view lower, size_t min_len,
+                           size_t max_len, std::vector<uint32_t> &out) {
+  out.clear();
+  for (size_t len = min_len; len <= max_len; len++) {
+    for (size_t i = 0; i + len <= lower.size(); i++)
+      out.push_back(gram_key(lower.substr(i, len)));
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void OptionIndex::index(uint32_t id) {
+  grams_of(lower_[id], 1, kMaxGram, grams_);
+  for (uint32_t g : grams_) {
+    std::vector<uint32_t> &ids = postings_[g];
+    // Appends land at the end; only edits in place pay for the shift
+    ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+  }
+  stats_.indexed++;
+}
+
+void OptionIndex::unindex(uint32_t id) {
+  grams_of(lower_[id], 1, kMaxGram, grams_);
+  for (uint32_t g : grams_) {
+    auto p = postings_.find(g);
+    if (p == postings_.end())
+      continue;
+    std::vector<uint32_t> &ids = p->second;
+    auto at = std::lower_bound(ids.begin(), ids.end(), id);
+    if (at != ids.end() && *at == id)
+      ids.erase(at);
+    if (ids.empty())
+      postings_.erase(p);
+  }
+  stats_.removed++;
+}
+
+void OptionIndex::set(uint32_t id, std::string_view text) {
+  if (id > text_.size())
+    return;
+  if (id == text_.size()) {
+    text_.emplace_back(text);
+    lower_.push_back(lowered(text));
+    index(id);
+    return;
+  }
+  if (text_[id] == text)
+    return;
+  unindex(id);
+  text_[id] = std::string(text);
+  lower_[id] = lowered(text);
+  index(id);
+}
+
+void OptionIndex::truncate(size_t n) {
+  while (text_.size() > n) {
+    unindex((uint32_t)(text_.size() - 1));
+    text_.pop_back();
+    lower_.pop_back();
+  }
+}
+
+void OptionIndex::clear() {
+  text_.clear();
+  lower_.clear();
+  postings_.clear();
+}
+
+void OptionIndex::assign(const std::vector<std::string> &options) {
+  truncate(options.size());
+  for (size_t i = 0; i < options.size(); i++) {
+    if (i < text_.size() && text_[i] == options[i]) {
+      stats_.unchanged++;
+      continue;
+    }
+    set((uint32_t)i, options[i]);
+  }
+}
+
+size_t OptionIndex::find(std::string_view query, size_t offset, size_t limit,
+                         std::vector<uint32_t> &page) const {
+  page.clear();
+  if (query.empty()) {
+    for (size_t i = offset; i < text_.size() && page.size() < limit; i++)
+      page.push_back((uint32_t)i);
+    return text_.size();
+  }
+
+  const std::string q = lowered(query);
+  if (q.size() <= kMaxGram) {
+    // Every id posted under the query's gram contains it
+    auto p = postings_.find(gram_key(q));
+    if (p == postings_.end())
+      return 0;
+    const std::vector<uint32_t> &ids = p->second;
+    for (size_t i = offset; i < ids.size() && page.size() < limit; i++)
+      page.push_back(ids[i]);
+    return ids.size();
+  }
+
+  grams_of(q, kMaxGram, kMaxGram, grams_);
+  const std::vector<uint32_t> *rarest = nullptr;
+  for (uint32_t g : grams_) {
+    auto p = postings_.find(g);
+    if (p == postings_.end())
+      return 0;
+    if (!rarest || p->second.size() < rarest->size())
+      rarest = &p->second;
+  }
+  size_t total = 0;
+  for (uint32_t id : *rarest) {
+    if (lower_[id].find(q) == std::string::npos)
+      continue;
+    if (total >= offset && page.size() < limit)
+      page.push_back(id);
+    total++;
+  }
+  return total;
+}
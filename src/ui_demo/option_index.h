@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Search index over dropdown options, for typeahead filtering of option sets
+// too large to scan every keystroke (asset ids, user names).
+//
+// Options are identified by their position, the same index a dropdown
+// selects by. Every query, whatever its length, matches options containing it
+// (ASCII case-insensitive), in option order, so typing another character only
+// ever narrows the list shown:
+//   ""           every option
+//   1-3 chars    the posting list of that gram, as is
+//   4+ chars     candidates from the query's rarest trigram's posting list,
+//                checked with a substring search
+// Each option is posted under every distinct 1, 2 and 3 character gram it
+// contains, so a query costs about as much as the options it could match,
+// not the whole set.
+//
+// assign() compares the new options with the indexed ones and only re-indexes
+// positions whose text changed, so appending to or editing a big list costs
+// the edit, not a rebuild. Removing from the middle shifts every later
+// position, and each of those counts as changed.
+class OptionIndex {
+public:
+  static constexpr size_t kMaxGram = 3;
+
+  struct Stats {
+    size_t options = 0;
+    size_t grams = 0;      // distinct grams with a posting list
+    uint64_t indexed = 0;  // options (re)indexed since construction
+    uint64_t removed = 0;  // options taken out of the index
+    uint64_t unchanged = 0; // options assign() found already indexed
+  };
+
+  void assign(const std::vector<std::string> &options);
+  // Replaces option `id`, or appends it when id == size()
+  void set(uint32_t id, std::string_view text);
+  // Drops options from the end
+  void truncate(size_t n);
+  void clear();
+
+  size_t size() const { return text_.size(); }
+  const std::string &text(uint32_t id) const { return text_[id]; }
+
+  // Writes matches [offset, offset + limit) of `query` to `page` and returns
+  // how many there are in total
+  size_t find(std::string_view query, size_t offset, size_t limit,
+              std::vector<uint32_t> &page) const;
+
+  Stats stats() const {
+    Stats s = stats_;
+    s.options = text_.size();
+    s.grams = postings_.size();
+    return s;
+  }
+
+private:
+  std::vector<std::string> text_;
+  std::vector<std::string> lower_;
+  // Gram (see gram_key) -> ids containing it, ascending
+  std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;
+  Stats stats_;
+  mutable std::vector<uint32_t> grams_; // scratch
+
+  static std::string lowered(std::string_view s);
+  static uint32_t gram_key(std::string_view gram);
+  static void grams_of(std::string_view lower, size_t min_len, size_t max_len,
+                       std::vector<uint32_t> &out);
+
+  void index(uint32_t id);
+  void unindex(uint32_t id);
+};
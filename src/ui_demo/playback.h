@@ -1,19 +1,86 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "ui_demo/input_mapping.h"
 
+// One [[step]]. Its actions live in PlaybackConfig::actions: `pressed_count`
+// pressed actions starting at `first`, then `held_count` held ones.
+// The step is applied on `repeat` consecutive frames and then followed by
+// `idle_frames` frames without input, so long soak runs stay a few entries.
+// `wait` (1-based index into PlaybackConfig::waits, 0 = none) holds the step
+// back until the live UI tree meets its conditions.
 struct PlaybackStep {
-  std::vector<InputAction> pressed;
-  std::vector<InputAction> held;
+  uint32_t first = 0;
+  uint16_t pressed_count = 0;
+  uint16_t held_count = 0;
+  uint32_t repeat = 1;
+  uint32_t idle_frames = 0;
+  uint32_t wait = 0;
+
+  uint64_t frames() const { return (uint64_t)repeat + idle_frames; }
+};
+
+// wait_for / wait_frames / wait_stable / timeout_frames of a [[step]]. All
+// given conditions must hold at once; on timeout the step runs anyway and the
+// run exits non-zero.
+struct PlaybackWait {
+  static constexpr uint32_t kDefaultTimeoutFrames = 1000; // 5 s at 200 FPS
+
+  std::string name;       // a UIComponentDebug name that must be in the tree
+  uint32_t frames = 0;    // frames to let pass first
+  uint32_t stable = 0;    // frames the tree (names and rects) must not change
+  // Counted after `frames`
+  uint32_t timeout_frames = kDefaultTimeoutFrames;
+};
+
+// Generated tree for the stress screen ([stress] table), see
+// ui_demo/examples/stress_tree.cpp and scripts/run_bench.js
+struct StressTreeConfig {
+  int nodes = 1000; // total generated nodes, including the container
+  int fanout = 8;   // children per node; 1 is a chain, >= nodes is flat
+  std::string sizing = "mixed"; // "pixels" | "percent" | "children" | "mixed"
+  int button_every = 0;         // every Nth leaf is a button (0 = none)
+};
+
+// Windowed list screen ([virtual_list] table), see
+// ui_demo/examples/virtual_list.cpp. ValueDown / ValueUp scroll it by
+// `scroll_step` rows.
+struct VirtualListConfig {
+  int64_t rows = 1000;
+  int columns = 1; // > 1 renders a grid of rows * columns cells
+  float row_height = 24.f;
+  int scroll_step = 1;
+};
+
+// Searchable dropdown screen ([typeahead] table), see
+// ui_demo/examples/typeahead.cpp
+struct TypeaheadConfig {
+  int options = 50000; // generated ids
+  std::string query;   // typed before the first frame
+  int page_size = 10;  // matches shown in the dropdown at once
+};
+
+// Subtree retention checks ([retention] table), see
+// ui_demo/subtree_retention.h. -1 leaves a field unset; the counts are what
+// the scenario must end with, checked when playback finishes like
+// p95_allocs_per_frame.
+struct RetentionConfig {
+  int64_t cap = -1;     // parked entities, instead of --retain-entities
+  int64_t reused = -1;  // subtrees shown again from parked
+  int64_t evicted = -1; // parked subtrees dropped for the cap
 };
 
 struct PlaybackConfig {
   std::vector<PlaybackStep> steps;
+  // Every step's actions back to back, see PlaybackStep
+  std::vector<InputAction> actions;
+  std::vector<PlaybackWait> waits;
   bool auto_quit = false;
   std::string dump_path = "ui_tree.json";
   // Per-run delay is configured via CLI, not TOML, to keep tests deterministic
@@ -25,6 +92,58 @@ struct PlaybackConfig {
   std::optional<std::string> button_color; // "Primary" | "Secondary" | "Accent"
                                            // | "Error" | "Background"
   std::optional<bool> button_disabled;     // true => disabled button
+
+  // Replaces the demo with a generated tree when present
+  std::optional<StressTreeConfig> stress;
+  // Same, with the windowed list screen
+  std::optional<VirtualListConfig> virtual_list;
+  std::optional<TypeaheadConfig> typeahead;
+  std::optional<RetentionConfig> retention;
+
+  // Fails the run when the p95 heap allocations per frame exceed this; turns
+  // on allocation counting (see ui_demo/alloc_stats.h)
+  std::optional<uint32_t> p95_allocs_per_frame;
+
+  std::span<const InputAction> pressed(const PlaybackStep &step) const {
+    return {actions.data() + step.first, step.pressed_count};
+  }
+  std::span<const InputAction> held(const PlaybackStep &step) const {
+    return {actions.data() + step.first + step.pressed_count,
+            step.held_count};
+  }
+
+  void add_step(std::span<const InputAction> pressed_actions,
+                std::span<const InputAction> held_actions, uint32_t repeat = 1,
+                uint32_t idle_frames = 0) {
+    PlaybackStep step;
+    step.first = (uint32_t)actions.size();
+    step.pressed_count = (uint16_t)pressed_actions.size();
+    step.held_count = (uint16_t)held_actions.size();
+    step.repeat = repeat;
+    step.idle_frames = idle_frames;
+    actions.insert(actions.end(), pressed_actions.begin(),
+                   pressed_actions.end());
+    actions.insert(actions.end(), held_actions.begin(), held_actions.end());
+    steps.push_back(step);
+  }
+
+  // Returns the value for PlaybackStep::wait
+  uint32_t add_wait(PlaybackWait wait) {
+    waits.push_back(std::move(wait));
+    return (uint32_t)waits.size();
+  }
+
+  const PlaybackWait *wait_for(const PlaybackStep &step) const {
+    return step.wait == 0 ? nullptr : &waits[step.wait - 1];
+  }
+
+  // Not counting frames spent in waits
+  uint64_t total_frames() const {
+    uint64_t frames = 0;
+    for (const PlaybackStep &step : steps)
+      frames += step.frames();
+    return frames;
+  }
 };
 
 extern std::optional<PlaybackConfig> g_playback_config;
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "ui_demo/alloc_tracker.h"
+#include <fmt/format.h>
+
+// Scoped per-frame timers for --profile=<file>.
+//
+// SystemManager lives in the afterhours submodule, so instead of timing
+// inside SystemManager::run we register marker systems around each group of
+// systems (see profile_update_group/profile_render_group). Markers run in
+// registration order, so a begin/end pair brackets exactly the systems that
+// were registered between them. Plugin registration helpers such as
+// ui::register_after_ui_updates add several systems at once; those show up
+// as one span for the whole call.
+//
+// Spans are written into a fixed ring of frames on the frame thread; the
+// only shared state is the committed frame counter, so a reader never takes
+// a lock and the frame thread never allocates.
+//
+// Each span also carries the heap allocations made inside it. Those are zero
+// unless alloc_tracker is counting (--alloc-stats or a scenario budget).
+struct FrameProfiler {
+  static constexpr size_t kMaxSpans = 64;
+  static constexpr size_t kMaxDepth = 16;
+  static constexpr size_t kRingFrames = 4096;
+
+  struct Span {
+    const char *name; // string literal, never freed
+    uint8_t depth;
+    int64_t start_ns; // relative to profiler start
+    int64_t dur_ns;
+    // Counts at begin() until end() turns them into deltas
+    uint64_t allocs;
+    uint64_t bytes;
+  };
+
+  struct Frame {
+    uint64_t index = 0;
+    size_t count = 0;
+    std::array<Span, kMaxSpans> spans;
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  std::unique_ptr<Frame[]> ring = std::make_unique<Frame[]>(kRingFrames);
+  std::atomic<uint64_t> committed{0};
+  Clock::time_point origin = Clock::now();
+  Frame *current = nullptr;
+  std::array<size_t, kMaxDepth> open{};
+  size_t depth = 0;
+  uint64_t dropped_spans = 0;
+
+  int64_t now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                origin)
+        .count();
+  }
+
+  void begin_frame() {
+    const uint64_t index = committed.load(std::memory_order_relaxed);
+    current = &ring[index % kRingFrames];
+    current->index = index;
+    current->count = 0;
+    depth = 0;
+    begin("frame");
+  }
+
+  void end_frame() {
+    // Close anything a marker pair left open so the frame is well formed
+    while (depth > 0)
+      end();
+    current = nullptr;
+    committed.fetch_add(1, std::memory_order_release);
+  }
+
+  void begin(const char *name) {
+    if (!current)
+      return;
+    if (current->count == kMaxSpans || depth == kMaxDepth) {
+      dropped_spans++;
+      return;
+    }
+    open[depth] = current->count;
+    const alloc_tracker::Counts c = alloc_tracker::counts();
+    current->spans[current->count++] =
+        Span{name, (uint8_t)depth, now_ns(), 0, c.allocs, c.bytes};
+    depth++;
+  }
+
+  void end() {
+    if (!current || depth == 0)
+      return;
+    Span &span = current->spans[open[--depth]];
+    span.dur_ns = now_ns() - span.start_ns;
+    const alloc_tracker::Counts c = alloc_tracker::counts();
+    span.allocs = c.allocs - span.allocs;
+    span.bytes = c.bytes - span.bytes;
+  }
+
+  // Oldest to newest frames still held by the ring
+  template <typename Fn> void for_each_frame(Fn &&fn) const {
+    const uint64_t end = committed.load(std::memory_order_acquire);
+    const uint64_t begin = end > kRingFrames ? end - kRingFrames : 0;
+    for (uint64_t i = begin; i < end; ++i)
+      fn(ring[i % kRingFrames]);
+  }
+
+  // Chrome trace-event JSON (chrome://tracing, Perfetto, speedscope)
+  bool write_chrome_trace(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out)
+      return false;
+    fmt::memory_buffer buf;
+    auto inserter = std::back_inserter(buf);
+    fmt::format_to(inserter, "{{\"traceEvents\":[");
+    bool first = true;
+    for_each_frame([&](const Frame &frame) {
+      for (size_t i = 0; i < frame.count; ++i) {
+        const Span &s = frame.spans[i];
+        fmt::format_to(inserter,
+                       "{}{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                       "\"ts\":{:.3f},\"dur\":{:.3f},"
+                       "\"args\":{{\"frame\":{}}}}}",
+                       first ? "" : ",", s.name, (double)s.start_ns / 1000.0,
+                       (double)s.dur_ns / 1000.0, frame.index);
+        first = false;
+      }
+      if (buf.size() > 64 * 1024) {
+        out.write(buf.data(), (std::streamsize)buf.size());
+        buf.clear();
+      }
+    });
+    fmt::format_to(inserter, "],\"displayTimeUnit\":\"ms\"}}");
+    out.write(buf.data(), (std::streamsize)buf.size());
+    return !out.fail();
+  }
+
+  struct Summary {
+    std::string name;
+    size_t samples = 0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+    double allocs_mean = 0.0;
+    uint64_t allocs_max = 0;
+    double bytes_mean = 0.0;
+  };
+
+  // Per span name, over every frame still in the ring. A name that appears
+  // more than once in a frame contributes one sample per occurrence.
+  std::vector<Summary> summarize() const {
+    struct Samples {
+      std::vector<int64_t> durs;
+      uint64_t allocs = 0;
+      uint64_t allocs_max = 0;
+      uint64_t bytes = 0;
+    };
+    std::map<std::string, Samples> by_name;
+    for_each_frame([&](const Frame &frame) {
+      for (size_t i = 0; i < frame.count; ++i) {
+        const Span &span = frame.spans[i];
+        Samples &samples = by_name[span.name];
+        samples.durs.push_back(span.dur_ns);
+        samples.allocs += span.allocs;
+        samples.allocs_max = std::max(samples.allocs_max, span.allocs);
+        samples.bytes += span.bytes;
+      }
+    });
+    std::vector<Summary> out;
+    for (auto &[name, samples] : by_name) {
+      std::vector<int64_t> &durs = samples.durs;
+      const double n = (double)durs.size();
+      std::sort(durs.begin(), durs.end());
+      auto pct = [&](double p) {
+        const size_t idx = std::min(
+            durs.size() - 1, (size_t)(p * (double)(durs.size() - 1) + 0.5));
+        return (double)durs[idx] / 1e6;
+      };
+      out.push_back(Summary{.name = name,
+                            .samples = durs.size(),
+                            .p50_ms = pct(0.50),
+                            .p95_ms = pct(0.95),
+                            .p99_ms = pct(0.99),
+                            .max_ms = (double)durs.back() / 1e6,
+                            .allocs_mean = (double)samples.allocs / n,
+                            .allocs_max = samples.allocs_max,
+                            .bytes_mean = (double)samples.bytes / n});
+    }
+    return out;
+  }
+
+  // summarize() as {"frames": n, "spans": {name: {samples, p50_ms, ...}}}
+  bool write_summary_json(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out)
+      return false;
+    fmt::memory_buffer buf;
+    auto inserter = std::back_inserter(buf);
+    fmt::format_to(inserter,
+                   "{{\"frames\":{},\"dropped_spans\":{},\"spans\":{{",
+                   std::min<uint64_t>(committed.load(), kRingFrames),
+                   dropped_spans);
+    bool first = true;
+    for (const Summary &s : summarize()) {
+      fmt::format_to(inserter,
+                     "{}\"{}\":{{\"samples\":{},\"p50_ms\":{:.6f},"
+                     "\"p95_ms\":{:.6f},\"p99_ms\":{:.6f},"
+                     "\"max_ms\":{:.6f}",
+                     first ? "" : ",", s.name, s.samples, s.p50_ms, s.p95_ms,
+                     s.p99_ms, s.max_ms);
+      if (alloc_tracker::enabled) {
+        fmt::format_to(inserter,
+                       ",\"allocs_mean\":{:.2f},\"allocs_max\":{},"
+                       "\"bytes_mean\":{:.1f}",
+                       s.allocs_mean, s.allocs_max, s.bytes_mean);
+      }
+      fmt::format_to(inserter, "}}");
+      first = false;
+    }
+    fmt::format_to(inserter, "}}}}\n");
+    out.write(buf.data(), (std::streamsize)buf.size());
+    return !out.fail();
+  }
+
+  void log_summary() const {
+    log_info("Frame profile over {} frames (ms): p50 / p95 / p99 / max",
+             std::min<uint64_t>(committed.load(), kRingFrames));
+    const bool allocs = alloc_tracker::enabled;
+    for (const Summary &s : summarize()) {
+      if (allocs) {
+        log_info("  {:<28} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f}  {:>8.1f} "
+                 "allocs (max {})",
+                 s.name, s.p50_ms, s.p95_ms, s.p99_ms, s.max_ms,
+                 s.allocs_mean, s.allocs_max);
+      } else {
+        log_info("  {:<28} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f}", s.name,
+                 s.p50_ms, s.p95_ms, s.p99_ms, s.max_ms);
+      }
+    }
+    if (dropped_spans > 0) {
+      log_warn("Profiler dropped {} spans (frame span limit {})",
+               dropped_spans, kMaxSpans);
+    }
+  }
+};
+
+// Registers `register_fn`'s update systems between a begin/end marker pair
+template <typename Systems, typename Fn>
+inline void profile_update_group(Systems &systems, FrameProfiler *profiler,
+                                 const char *name, Fn &&register_fn) {
+  if (!profiler) {
+    register_fn();
+    return;
+  }
+  systems.register_update_system(
+      [profiler, name](float) { profiler->begin(name); });
+  register_fn();
+  systems.register_update_system([profiler](float) { profiler->end(); });
+}
+
+// Same as profile_update_group for render systems
+template <typename Systems, typename Fn>
+inline void profile_render_group(Systems &systems, FrameProfiler *profiler,
+                                 const char *name, Fn &&register_fn) {
+  if (!profiler) {
+    register_fn();
+    return;
+  }
+  systems.register_render_system(
+      [profiler, name](float) { profiler->begin(name); });
+  register_fn();
+  systems.register_render_system([profiler](float) { profiler->end(); });
+}
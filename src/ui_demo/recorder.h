@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "magic_enum/magic_enum.hpp"
+#include "ui_demo/input_mapping.h"
+
+// Records the InputAction stream for --record=<file> as a playback TOML that
+// --actions= replays frame for frame.
+//
+// Each frame's held (inputs()) and pressed (inputs_pressed()) actions are
+// reduced to two bitmasks. Consecutive identical frames are one run, so the
+// per-frame cost is a couple of loops over the collector and a compare, with
+// no allocation. Runs go into a fixed ring that is written out as [[step]]
+// tables when it fills up and when recording finishes. A run with input
+// becomes a step with `repeat`; an input-free run becomes the previous step's
+// `idle_frames`.
+//
+// Replay is frame exact, not time exact: playback runs with a fixed dt.
+struct InputRecorder {
+  static_assert(magic_enum::enum_count<InputAction>() <= 64,
+                "InputAction no longer fits the recorder's bitmasks");
+  static constexpr size_t kRingRuns = 4096;
+
+  struct Run {
+    uint64_t pressed = 0;
+    uint64_t held = 0;
+    uint32_t frames = 0;
+
+    bool idle() const { return pressed == 0 && held == 0; }
+  };
+
+  std::ofstream out;
+  std::vector<Run> ring;
+  size_t runs = 0;
+  uint64_t frame = 0;
+  // The last step is held back until we know whether idle frames follow it
+  Run pending;
+  uint32_t pending_idle = 0;
+  bool has_pending = false;
+  size_t steps_written = 0;
+
+  explicit InputRecorder(const std::string &path) : out(path), ring(kRingRuns) {
+    out << "# Recorded with --record; replay with --actions=<this file>\n"
+        << "autoquit = true\n"
+        << "dump_path = \"ui_tree.json\"\n";
+  }
+
+  ~InputRecorder() { finish(); }
+
+  bool ok() const { return out.good(); }
+
+  // Call once per frame after input collection and playback injection
+  void record_frame() {
+    uint64_t pressed = 0;
+    uint64_t held = 0;
+    auto pic = afterhours::input::get_input_collector<InputAction>();
+    if (pic.has_value()) {
+      for (const auto &done : pic.inputs_pressed())
+        pressed |= 1ull << (size_t)done.action;
+      for (const auto &done : pic.inputs())
+        held |= 1ull << (size_t)done.action;
+    }
+    frame++;
+    if (runs > 0) {
+      Run &last = ring[runs - 1];
+      if (last.pressed == pressed && last.held == held &&
+          last.frames < UINT32_MAX) {
+        last.frames++;
+        return;
+      }
+    }
+    if (runs == ring.size())
+      flush_runs();
+    ring[runs++] = Run{pressed, held, 1};
+  }
+
+  // Writes everything recorded so far; safe to call more than once
+  void finish() {
+    if (!out.is_open())
+      return;
+    flush_runs();
+    if (has_pending)
+      write_step(pending, pending_idle);
+    has_pending = false;
+    out.close();
+  }
+
+  void flush_runs() {
+    for (size_t i = 0; i < runs; i++) {
+      const Run &run = ring[i];
+      if (run.idle()) {
+        if (!has_pending) {
+          // Idle before the first input: a step with only idle_frames
+          pending = Run{};
+          pending_idle = 0;
+          has_pending = true;
+        }
+        pending_idle += run.frames;
+        continue;
+      }
+      if (has_pending)
+        write_step(pending, pending_idle);
+      pending = run;
+      pending_idle = 0;
+      has_pending = true;
+    }
+    runs = 0;
+  }
+
+  void write_actions(const char *key, uint64_t mask) {
+    if (mask == 0)
+      return;
+    out << key << " = [";
+    bool first = true;
+    for (InputAction a : magic_enum::enum_values<InputAction>()) {
+      if (!(mask & (1ull << (size_t)a)))
+        continue;
+      out << (first ? "\"" : ", \"") << magic_enum::enum_name(a) << '"';
+      first = false;
+    }
+    out << "]\n";
+  }
+
+  void write_step(const Run &run, uint32_t idle_frames) {
+    out << "\n[[step]]\n";
+    write_actions("pressed", run.pressed);
+    write_actions("held", run.held);
+    if (!run.idle() && run.frames != 1)
+      out << "repeat = " << run.frames << '\n';
+    if (idle_frames > 0)
+      out << "idle_frames = " << idle_frames << '\n';
+    steps_written++;
+  }
+};
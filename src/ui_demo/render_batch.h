@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "rl.h"
+
+// rlgl render batch for the UI render pass (ui::register_render_systems).
+//
+// rlgl already merges consecutive draws that share a texture and mode into one
+// GL draw call, and only submits the batch when its vertex buffer or draw
+// table fills up, on state changes such as scissor, and at EndDrawing. A
+// dense panel overflows raylib's default batch (8192 quads, one vertex
+// buffer on desktop) several times a frame, and every overflow re-uploads the
+// one VBO the GPU may still be drawing from. The UI pass draws into this
+// batch instead: four times the quads and kBuffers vertex buffers, so a busy
+// pass is usually one submission and any extra ones don't stall on each
+// other. Draw order inside the pass is kept; RenderImm already orders it by
+// render layer and overlap depends on it.
+//
+// rlgl has no hooks, so the per-frame counts are read back from the batch:
+//   draws     rlBegin/rlEnd pairs (a rect, a rounded rect, one glyph, ...);
+//             rlEnd advances the batch depth by 1/20000 until the next submit
+//   gl_draws  draw table entries with vertices, one GL draw call each
+//   submits   every submit resets the draw table and moves on to the next
+//             vertex buffer
+// When the batch was submitted in the middle of the pass, draws only covers
+// what came after and gl_draws counts one per earlier submit (`partial`).
+struct UIRenderBatch {
+  static constexpr int kBuffers = 4;
+  static constexpr int kElements = 4 * 8192; // quads per vertex buffer
+  // Never written by rlgl except when a submit resets the whole draw table
+  static constexpr unsigned int kSentinelTexture = 0xffffffffu;
+  static constexpr int kSentinelSlot = RL_DEFAULT_BATCH_DRAWCALLS - 1;
+
+  struct Frame {
+    uint32_t draws = 0;
+    uint32_t gl_draws = 0;
+    uint32_t submits = 0;
+    bool partial = false;
+  };
+
+  raylib::rlRenderBatch batch{};
+  bool loaded = false;
+  int start_buffer = 0;
+  Frame last;
+
+  // Needs the GL context, so after InitWindow and before CloseWindow
+  void load() {
+    batch = raylib::rlLoadRenderBatch(kBuffers, kElements);
+    loaded = batch.draws != nullptr;
+  }
+
+  void unload() {
+    if (loaded)
+      raylib::rlUnloadRenderBatch(batch);
+    loaded = false;
+  }
+
+  void begin_pass() {
+    if (!loaded)
+      return;
+    // Submits whatever was drawn before the UI (the clear) on the default one
+    raylib::rlSetRenderBatchActive(&batch);
+    start_buffer = batch.currentBuffer;
+    batch.draws[kSentinelSlot].textureId = kSentinelTexture;
+  }
+
+  void end_pass() {
+    if (!loaded)
+      return;
+    Frame f;
+    int earlier = (batch.currentBuffer - start_buffer + kBuffers) % kBuffers;
+    const bool submitted =
+        batch.draws[kSentinelSlot].textureId != kSentinelTexture;
+    if (earlier == 0 && submitted)
+      earlier = kBuffers; // went all the way round; at least this many
+    for (int i = 0; i < batch.drawCounter; i++) {
+      if (batch.draws[i].vertexCount > 0)
+        f.gl_draws++;
+    }
+    f.draws = (uint32_t)std::lround((batch.currentDepth + 1.0f) * 20000.0f);
+    f.submits = (uint32_t)earlier + (f.gl_draws > 0 ? 1u : 0u);
+    f.gl_draws += (uint32_t)earlier;
+    f.partial = earlier > 0;
+    // Submits the rest and hands the default batch back to RenderFPS & co
+    raylib::rlSetRenderBatchActive(nullptr);
+    last = f;
+  }
+};
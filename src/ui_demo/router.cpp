@@ -1,9 +1,12 @@
 #include "router.h"
+#include "afterhours/src/plugins/input_system.h"
 #include "afterhours/src/plugins/ui/immediate.h"
 #include "afterhours/src/plugins/ui/systems.h"
 #include "ui_demo/data.h"
 #include "ui_demo/examples/examples.h"
+#include "ui_demo/intern.h"
 #include "ui_demo/playback.h"
+#include "ui_demo/subtree_retention.h"
 
 using namespace afterhours;
 using namespace afterhours::ui;
@@ -12,28 +15,37 @@ using namespace afterhours::ui::imm;
 extern std::optional<PlaybackConfig> g_playback_config; // from main.cpp
 
 // Extracted example rendering: overlay + one or more example screens
+//
+// A parked page (ui_demo/subtree_retention.h) is still emitted every frame
+// with its root hidden. Its widgets can't be tabbed to, edit copies of their
+// values and their presses are ignored, so nothing it receives while hidden
+// reaches demo state.
 static void render_home_page(DemoRouter::UIX &context,
                              afterhours::Entity &contentParent,
-                             ExampleState &examples) {
+                             DemoState &state, ExampleState &examples,
+                             bool parked) {
   auto content = div(context, mk(contentParent, 0),
                      ComponentConfig()
                          .with_size(ComponentSize{percent(1.f), children()})
                          .with_flex_direction(FlexDirection::Column)
-                         .with_debug_name("home_content"));
+                         .with_debug_name("home_content"_interned));
 
   div(context, mk(content.ent(), 0),
       ComponentConfig()
-          .with_label("Afterhours UI Demo: Use the nav bar to switch pages.")
+          .with_label(
+              "Afterhours UI Demo: Use the nav bar to switch pages."_interned)
           .with_size(ComponentSize{children(), pixels(50.f)})
           .with_skip_tabbing(true)
-          .with_debug_name("home_intro"));
+          .with_debug_name("home_intro"_interned));
 
   if (button(context, mk(content.ent(), 1),
              ComponentConfig()
-                 .with_label("Open Examples")
+                 .with_label("Open Examples"_interned)
                  .with_size(ComponentSize{pixels(220.f), pixels(50.f)})
                  .with_select_on_focus(true)
-                 .with_debug_name("open_examples"))) {
+                 .with_skip_tabbing(parked)
+                 .with_debug_name("open_examples"_interned)) &&
+      !parked) {
     examples.showing = true;
   }
 
@@ -41,39 +53,59 @@ static void render_home_page(DemoRouter::UIX &context,
                      ComponentConfig()
                          .with_size(ComponentSize{percent(1.f), children()})
                          .with_flex_direction(FlexDirection::Row)
-                         .with_debug_name("home_gallery"));
+                         .with_debug_name("home_gallery"_interned));
 
-  static bool home_checkbox = false;
-  static float home_slider = 0.25f;
-  static size_t home_dd = 0;
   const std::vector<std::string> &dd_opts =
       ui_demo::data::basic_color_options_vec();
 
-  button(context, mk(gallery.ent(), 0), ComponentConfig().with_label("Button"));
-  checkbox(context, mk(gallery.ent(), 1), home_checkbox,
-           ComponentConfig().with_label("Checkbox"));
-  slider(context, mk(gallery.ent(), 2), home_slider,
-         ComponentConfig().with_label("Slider"));
-  dropdown(context, mk(gallery.ent(), 3), dd_opts, home_dd,
-           ComponentConfig().with_label("Dropdown"));
+  bool checked = state.home_checkbox;
+  float level = state.home_slider;
+  size_t color = state.home_dropdown;
+  button(context, mk(gallery.ent(), 0),
+         ComponentConfig()
+             .with_label("Button"_interned)
+             .with_skip_tabbing(parked));
+  checkbox(context, mk(gallery.ent(), 1), checked,
+           ComponentConfig()
+               .with_label("Checkbox"_interned)
+               .with_skip_tabbing(parked));
+  slider(context, mk(gallery.ent(), 2), level,
+         ComponentConfig()
+             .with_label("Slider"_interned)
+             .with_skip_tabbing(parked));
+  dropdown(context, mk(gallery.ent(), 3), dd_opts, color,
+           ComponentConfig()
+               .with_label("Dropdown"_interned)
+               .with_skip_tabbing(parked));
+  if (!parked) {
+    state.home_checkbox = checked;
+    state.home_slider = level;
+    state.home_dropdown = color;
+  }
 
-  if (g_playback_config.has_value())
+  // Playback starts on the overlay, once, so scenarios can still close it
+  if (g_playback_config.has_value() && !parked &&
+      !examples.opened_for_playback) {
+    examples.opened_for_playback = true;
     examples.showing = true;
+  }
 }
 
 // Extracted example rendering: overlay + one or more example screens
 // Example A body moved to ui_demo/examples/example_a.cpp
 
-static void render_examples_overlay(DemoRouter::UIX &context,
-                                    afterhours::Entity &rootEntity,
-                                    ExampleState &examples) {
+static afterhours::Entity &
+render_examples_overlay(DemoRouter::UIX &context,
+                        afterhours::Entity &rootEntity,
+                        ExampleState &examples, bool parked) {
   auto overlay =
       div(context, mk(rootEntity, 1001),
           ComponentConfig()
               .with_size(ComponentSize{pixels(1100.f), pixels(650.f)})
               .with_absolute_position()
               .with_color_usage(Theme::Usage::Background)
-              .with_debug_name("examples_overlay"));
+              .with_hidden(parked)
+              .with_debug_name("examples_overlay"_interned));
 
   auto panel =
       div(context, mk(overlay.ent(), 0),
@@ -81,31 +113,48 @@ static void render_examples_overlay(DemoRouter::UIX &context,
               .with_size(ComponentSize{pixels(1000.f), pixels(600.f)})
               .with_margin(Margin{.top = pixels(25.f), .left = pixels(50.f)})
               .with_color_usage(Theme::Usage::Secondary)
-              .with_debug_name("examples_panel"));
+              .with_debug_name("examples_panel"_interned));
 
   // Title uses scenario name if provided, else default
-  const char *title = "Examples";
+  const std::string *title = &"Examples"_interned.str();
   if (g_playback_config.has_value() &&
       !g_playback_config->scenario_name.empty()) {
-    title = g_playback_config->scenario_name.c_str();
+    title = &g_playback_config->scenario_name;
   }
   div(context, mk(panel.ent(), 0),
       ComponentConfig()
-          .with_label(title)
+          .with_label(*title)
           .with_size(ComponentSize{children(), pixels(50.f)})
           .with_color_usage(Theme::Usage::Primary)
-          .with_debug_name("example_header"));
+          .with_debug_name("example_header"_interned));
 
   // Body of current example screen (match actions/single_button)
-  ui_demo::examples::render_single_button(context, panel.ent());
+  ui_demo::examples::render_single_button(context, panel.ent(), examples,
+                                           parked);
 
   if (button(context, mk(panel.ent(), 2),
              ComponentConfig()
-                 .with_label("Close")
+                 .with_label("Close"_interned)
                  .with_size(ComponentSize{pixels(220.f), pixels(50.f)})
-                 .with_debug_name("examples_close"))) {
+                 .with_skip_tabbing(parked)
+                 .with_debug_name("examples_close"_interned)) &&
+      !parked) {
     examples.showing = false;
   }
+  return overlay.ent();
+}
+
+// F1 (ToggleExamples) flips the overlay without going through focus, which
+// also gives scenarios a way to toggle it that doesn't depend on tab order
+static bool toggle_examples_pressed() {
+  auto pic = input::get_input_collector<InputAction>();
+  if (!pic.has_value())
+    return false;
+  for (const auto &done : pic.inputs_pressed()) {
+    if (done.action == InputAction::ToggleExamples)
+      return true;
+  }
+  return false;
 }
 
 void DemoRouter::for_each_with(afterhours::Entity &entity, UIX &context,
@@ -119,34 +168,74 @@ void DemoRouter::for_each_with(afterhours::Entity &entity, UIX &context,
                   ComponentConfig()
                       .with_size(ComponentSize{pixels(1100.f), pixels(650.f)})
                       .with_flex_direction(FlexDirection::Column)
-                      .with_debug_name("demo_root"));
+                      .with_debug_name("demo_root"_interned));
+
+  // Benchmark scenarios replace the whole demo with a generated tree
+  if (g_playback_config.has_value() && g_playback_config->stress.has_value()) {
+    ui_demo::examples::render_stress_tree(context, root.ent(),
+                                          *g_playback_config->stress);
+    return;
+  }
+  if (g_playback_config.has_value() &&
+      g_playback_config->virtual_list.has_value()) {
+    ui_demo::examples::render_virtual_list(context, root.ent(),
+                                           *g_playback_config->virtual_list);
+    return;
+  }
+  if (g_playback_config.has_value() &&
+      g_playback_config->typeahead.has_value()) {
+    ui_demo::examples::render_typeahead(context, root.ent(),
+                                        *g_playback_config->typeahead);
+    return;
+  }
 
-  if (!examples.showing) {
-    navigation_bar(context, mk(root.ent(), 0), page_names,
-                   state.current_page_index,
-                   ComponentConfig()
-                       .with_size(ComponentSize{percent(1.f), pixels(50.f)})
-                       .with_flex_direction(FlexDirection::Row)
-                       .with_debug_name("nav_bar"));
+  if (toggle_examples_pressed())
+    examples.showing = !examples.showing;
+
+  // The overlay and the page it covers are swapped rather than rebuilt; the
+  // hidden one stays parked while it fits (ui_demo/subtree_retention.h)
+  SubtreeRetention &retention = SubtreeRetention::get();
+  const SubtreeRetention::Emit main_emit =
+      retention.begin("main_branch"_interned, !examples.showing);
+  if (main_emit != SubtreeRetention::Emit::Skip) {
+    const bool parked = main_emit == SubtreeRetention::Emit::Parked;
+    size_t page = state.current_page_index;
+    auto nav = navigation_bar(
+        context, mk(root.ent(), 0), page_names, page,
+        ComponentConfig()
+            .with_size(ComponentSize{percent(1.f), pixels(50.f)})
+            .with_flex_direction(FlexDirection::Row)
+            .with_hidden(parked)
+            .with_skip_tabbing(parked)
+            .with_debug_name("nav_bar"_interned));
+    if (!parked)
+      state.current_page_index = page;
 
     auto content = div(context, mk(root.ent(), 1),
                        ComponentConfig()
                            .with_size(ComponentSize{percent(1.f), children()})
                            .with_flex_direction(FlexDirection::Column)
-                           .with_debug_name("content"));
+                           .with_hidden(parked)
+                           .with_debug_name("content"_interned));
 
     switch (state.current_page_index) {
     case 0: {
-      render_home_page(context, content.ent(), examples);
+      render_home_page(context, content.ent(), state, examples, parked);
       break;
     }
     default:
       break;
     }
+    retention.end("main_branch"_interned, {&nav.ent(), &content.ent()});
   }
 
   // Render examples overlay on top when active (independent of main content)
-  if (examples.showing) {
-    render_examples_overlay(context, root.ent(), examples);
+  const SubtreeRetention::Emit overlay_emit =
+      retention.begin("examples_overlay"_interned, examples.showing);
+  if (overlay_emit != SubtreeRetention::Emit::Skip) {
+    afterhours::Entity &overlay =
+        render_examples_overlay(context, root.ent(), examples,
+                                overlay_emit == SubtreeRetention::Emit::Parked);
+    retention.end("examples_overlay"_interned, {&overlay});
   }
 }
@@ -7,13 +7,23 @@
 #include "afterhours/src/system.h"
 #include "ui_demo/input_mapping.h"
 
+// Demo state lives in components on the main entity, so batch mode's world
+// reset between scenarios starts every scenario from these defaults
 struct DemoState : public afterhours::BaseComponent {
   size_t current_page_index = 0;
+  // Home page gallery
+  bool home_checkbox = false;
+  float home_slider = 0.25f;
+  size_t home_dropdown = 0;
 };
 
 struct ExampleState : public afterhours::BaseComponent {
   bool showing = false;
+  bool opened_for_playback = false;
   size_t screen_index = 0;
+  // single_button example
+  bool enabled_checkbox = true;
+  float strength = 0.5f;
 };
 
 struct DemoRouter : afterhours::System<afterhours::ui::UIContext<InputAction>> {
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "rl.h"
+
+// Source of the dt handed to SystemManager::run each frame.
+//
+// RealTime uses raylib's measured frame time and is what interactive runs
+// use. Fixed hands out the same dt every frame no matter how long the frame
+// took, so playback (and the --delay countdown) depends only on the frame
+// count. That makes a capped 200 FPS run and an uncapped --fast-forward run
+// see the exact same sequence of dts and produce identical trees.
+struct SimClock {
+  enum struct Mode { RealTime, Fixed };
+
+  // Matches the SetTargetFPS(200) cap so fixed playback runs at real speed
+  // when the cap is on
+  static constexpr float kDefaultFixedDt = 1.0f / 200.0f;
+
+  Mode mode = Mode::RealTime;
+  float fixed_dt = kDefaultFixedDt;
+  uint64_t frame = 0;
+  double elapsed = 0.0;
+
+  void use_fixed(float dt = kDefaultFixedDt) {
+    mode = Mode::Fixed;
+    fixed_dt = dt;
+  }
+
+  float tick() {
+    const float dt =
+        mode == Mode::Fixed ? fixed_dt : raylib::GetFrameTime();
+    frame++;
+    elapsed += dt;
+    return dt;
+  }
+};
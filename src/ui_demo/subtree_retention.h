@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// Ensure Raylib-backed types/macros are defined before any afterhours includes
+#include "rl.h"
+
+#include "afterhours/src/plugins/ui/immediate.h"
+#include "ui_demo/intern.h"
+
+// Retention policy for immediate-mode subtrees that get toggled, such as the
+// examples overlay and the nav bar / content branch it replaces.
+//
+// A subtree that is no longer emitted loses its entities, and showing it again
+// creates every entity, component and layout result from scratch, which is a
+// frame spike on each open / close. Instead, a subtree that goes from shown to
+// hidden is parked: the caller keeps emitting it with its root hidden, so the
+// same entities (same mk() ids) stay alive with their state, and showing it
+// again only clears the flag on the root.
+//
+//   switch (retention.begin("examples_overlay"_interned, showing))
+//     Skip    don't emit it
+//     Live    emit it as usual
+//     Parked  emit it with .with_hidden(true) on its root
+//   retention.end(key, {&root})   after emitting a Live or Parked subtree,
+//                                 with each of its roots
+//
+// Parked subtrees are capped by entity count (--retain-entities, 0 turns
+// parking off). The oldest parked subtrees are dropped first, and come back
+// as new entities the next time they are shown.
+//
+// Parking is not free: immediate mode only keeps what is emitted, so a
+// parked subtree still runs all of its widget calls and config building
+// every frame, it is only hidden. That steady cost is traded for the rebuild
+// spike, which pays off for subtrees that are toggled often and cheap to
+// emit; the cap bounds it.
+class SubtreeRetention {
+public:
+  static constexpr size_t kDefaultCapEntities = 4096;
+
+  enum struct Emit { Skip, Live, Parked };
+
+  struct Stats {
+    uint64_t created = 0;  // shown with new entities
+    uint64_t reused = 0;   // shown again from a parked subtree
+    uint64_t evicted = 0;  // parked subtrees dropped for the cap
+    size_t parked = 0;
+    size_t parked_entities = 0;
+  };
+
+  static SubtreeRetention &get() {
+    static SubtreeRetention retention;
+    return retention;
+  }
+
+  // Once per frame per subtree, before emitting it
+  Emit begin(InternedString key, bool visible) {
+    Slot &s = slot(key);
+    if (visible) {
+      if (s.state == Emit::Parked) {
+        stats_.reused++;
+        unpark(s);
+      } else if (s.state == Emit::Skip) {
+        stats_.created++;
+      }
+      s.state = Emit::Live;
+      return Emit::Live;
+    }
+    if (s.state == Emit::Live) {
+      s.state = cap_ > 0 ? Emit::Parked : Emit::Skip;
+      s.parked_at = ++parks_;
+      s.measured = false;
+    }
+    return s.state;
+  }
+
+  // After emitting a Live or Parked subtree. Sizes a subtree the frame it is
+  // parked and drops the oldest ones while over the cap.
+  void end(InternedString key,
+           std::initializer_list<afterhours::Entity *> roots) {
+    Slot &s = slot(key);
+    if (s.state != Emit::Parked || s.measured)
+      return;
+    s.measured = true;
+    s.entities = 0;
+    for (afterhours::Entity *root : roots)
+      s.entities += count_entities(*root);
+    parked_entities_ += s.entities;
+    while (parked_entities_ > cap_) {
+      Slot *oldest = nullptr;
+      for (Slot &o : slots_) {
+        if (o.state == Emit::Parked && o.measured &&
+            (!oldest || o.parked_at < oldest->parked_at))
+          oldest = &o;
+      }
+      if (!oldest)
+        break;
+      unpark(*oldest);
+      oldest->state = Emit::Skip;
+      stats_.evicted++;
+    }
+  }
+
+  // After deleting the entities behind the subtrees; keeps the counters
+  void clear() {
+    slots_.clear();
+    parked_entities_ = 0;
+  }
+
+  void set_cap(size_t entities) { cap_ = entities; }
+  size_t cap() const { return cap_; }
+
+  Stats stats() const {
+    Stats s = stats_;
+    s.parked_entities = parked_entities_;
+    for (const Slot &o : slots_)
+      s.parked += o.state == Emit::Parked ? 1 : 0;
+    return s;
+  }
+
+private:
+  // A handful of toggled subtrees per screen, so a flat list
+  struct Slot {
+    InternedString key;
+    Emit state = Emit::Skip;
+    bool measured = false;
+    size_t entities = 0;
+    uint64_t parked_at = 0;
+  };
+
+  size_t cap_ = kDefaultCapEntities;
+  std::vector<Slot> slots_;
+  size_t parked_entities_ = 0;
+  uint64_t parks_ = 0;
+  Stats stats_;
+
+  Slot &slot(InternedString key) {
+    for (Slot &s : slots_) {
+      if (s.key == key)
+        return s;
+    }
+    return slots_.emplace_back(Slot{key});
+  }
+
+  void unpark(Slot &s) {
+    if (s.measured)
+      parked_entities_ -= s.entities;
+    s.measured = false;
+    s.entities = 0;
+  }
+
+  static size_t count_entities(afterhours::Entity &root) {
+    using afterhours::ui::UIComponent;
+    static std::vector<afterhours::EntityID> stack;
+    stack.assign(1, root.id);
+    size_t n = 0;
+    while (!stack.empty()) {
+      const afterhours::EntityID id = stack.back();
+      stack.pop_back();
+      auto opt = afterhours::EntityHelper::getEntityForID(id);
+      if (!opt)
+        continue;
+      n++;
+      afterhours::Entity &e = opt.asE();
+      if (e.has<UIComponent>()) {
+        for (afterhours::EntityID child : e.get<UIComponent>().children)
+          stack.push_back(child);
+      }
+    }
+    return n;
+  }
+};
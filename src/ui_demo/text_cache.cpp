@@ -0,0 +1,136 @@
+#include "ui_demo/text_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+// rl.h routes raylib::MeasureTextEx / raylib::DrawTextEx here
+namespace raylib {
+
+Vector2 MeasureTextExCached(Font font, const char *text, float fontSize,
+                            float spacing) {
+  return TextLayoutCache::get().measure(font, text, fontSize, spacing);
+}
+
+void DrawTextExCached(Font font, const char *text, Vector2 position,
+                      float fontSize, float spacing, Color tint) {
+  TextLayoutCache::get().draw(font, text, position, fontSize, spacing, tint);
+}
+
+} // namespace raylib
+
+raylib::Vector2 TextLayoutCache::measure(const raylib::Font &font,
+                                         const char *text, float size,
+                                         float spacing) {
+  if (capacity_ == 0 || text == nullptr) {
+    stats_.bypassed++;
+    return raylib::MeasureTextExUncached(font, text, size, spacing);
+  }
+  Entry &e = lookup(font, text, size, spacing);
+  if (e.has_extent) {
+    stats_.hits++;
+    return e.extent;
+  }
+  stats_.misses++;
+  e.extent = raylib::MeasureTextExUncached(font, text, size, spacing);
+  e.has_extent = true;
+  return e.extent;
+}
+
+void TextLayoutCache::draw(const raylib::Font &font_in, const char *text,
+                           raylib::Vector2 position, float size,
+                           float spacing, raylib::Color tint) {
+  // raylib draws line breaks with its own (unreadable) line spacing
+  if (capacity_ == 0 || text == nullptr || std::strchr(text, '\n')) {
+    stats_.bypassed++;
+    raylib::DrawTextExUncached(font_in, text, position, size, spacing, tint);
+    return;
+  }
+  const raylib::Font font =
+      font_in.texture.id == 0 ? raylib::GetFontDefault() : font_in;
+  Entry &e = lookup(font, text, size, spacing);
+  if (e.has_glyphs) {
+    stats_.hits++;
+  } else {
+    stats_.misses++;
+    build_glyphs(font, e);
+  }
+
+  // Same quads as DrawTextCodepoint
+  const float scale = size / (float)font.baseSize;
+  const float pad = (float)font.glyphPadding;
+  for (const Glyph &g : e.glyphs) {
+    const raylib::Rectangle &rec = font.recs[g.index];
+    const raylib::GlyphInfo &info = font.glyphs[g.index];
+    const raylib::Rectangle src{rec.x - pad, rec.y - pad,
+                                rec.width + 2.f * pad,
+                                rec.height + 2.f * pad};
+    const raylib::Rectangle dst{
+        position.x + g.x + ((float)info.offsetX - pad) * scale,
+        position.y + ((float)info.offsetY - pad) * scale, src.width * scale,
+        src.height * scale};
+    raylib::DrawTexturePro(font.texture, src, dst, raylib::Vector2{0.f, 0.f},
+                           0.f, tint);
+  }
+}
+
+TextLayoutCache::Entry &TextLayoutCache::lookup(const raylib::Font &font,
+                                                std::string_view text,
+                                                float size, float spacing) {
+  auto it = index_.find(key_for(font, text, size, spacing));
+  if (it != index_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return *it->second;
+  }
+  Entry &e = lru_.emplace_front();
+  e.text = std::string(text);
+  e.font = (uintptr_t)font.glyphs;
+  e.size = size;
+  e.spacing = spacing;
+  index_.emplace(key_for(font, e.text, size, spacing), lru_.begin());
+  stats_.entries++;
+  account(e);
+  return e;
+}
+
+// Pen positions as DrawTextEx computes them, without the draw calls
+void TextLayoutCache::build_glyphs(const raylib::Font &font, Entry &e) {
+  const float scale = e.size / (float)font.baseSize;
+  const char *text = e.text.c_str();
+  const int len = (int)e.text.size();
+  float x = 0.f;
+  for (int i = 0; i < len;) {
+    int bytes = 0;
+    const int codepoint = raylib::GetCodepointNext(text + i, &bytes);
+    const int index = raylib::GetGlyphIndex(font, codepoint);
+    if (codepoint != ' ' && codepoint != '\t')
+      e.glyphs.push_back(Glyph{index, x});
+    const int advance = font.glyphs[index].advanceX;
+    x += (advance == 0 ? font.recs[index].width : (float)advance) * scale +
+         e.spacing;
+    i += std::max(bytes, 1);
+  }
+  e.glyphs.shrink_to_fit();
+  e.has_glyphs = true;
+  account(e);
+}
+
+void TextLayoutCache::account(Entry &e) {
+  const size_t bytes = kEntryOverhead + e.text.capacity() +
+                       e.glyphs.capacity() * sizeof(Glyph);
+  stats_.bytes += bytes - e.bytes;
+  e.bytes = bytes;
+  evict();
+}
+
+// Never evicts the front entry, which the caller may be holding
+void TextLayoutCache::evict() {
+  while (stats_.bytes > capacity_ && lru_.size() > 1) {
+    const Entry &victim = lru_.back();
+    index_.erase(Key{victim.font, std::bit_cast<uint32_t>(victim.size),
+                     std::bit_cast<uint32_t>(victim.spacing), victim.text});
+    stats_.bytes -= victim.bytes;
+    stats_.entries--;
+    stats_.evictions++;
+    lru_.pop_back();
+  }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "rl.h"
+
+// Measured extents and glyph runs of label text, keyed by (font, size,
+// spacing, string).
+//
+// Label sizing in autolayout and label drawing in RenderImm both live in the
+// afterhours submodule and call raylib::MeasureTextEx / raylib::DrawTextEx.
+// rl.h maps those two names onto the cached versions in text_cache.cpp, so
+// both go through here without changes to the submodule. Labels such as
+// "Open Examples" never change, so after the first frame measuring one is a
+// hash lookup and drawing one skips the UTF-8 decode and glyph search.
+//
+// Entries are kept in LRU order and evicted once their approximate size goes
+// over the capacity (--text-cache-kb). A capacity of 0 turns the cache off.
+// Fonts are told apart by their glyph table, which lives as long as the font
+// is loaded; clear() after unloading fonts.
+class TextLayoutCache {
+public:
+  static constexpr size_t kDefaultCapacityBytes = 1 << 20;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t bypassed = 0; // multi-line draws, cache off
+    size_t entries = 0;
+    size_t bytes = 0;
+  };
+
+  static TextLayoutCache &get() {
+    static TextLayoutCache cache;
+    return cache;
+  }
+
+  raylib::Vector2 measure(const raylib::Font &font, const char *text,
+                          float size, float spacing);
+  void draw(const raylib::Font &font, const char *text,
+            raylib::Vector2 position, float size, float spacing,
+            raylib::Color tint);
+
+  void set_capacity(size_t bytes) {
+    capacity_ = bytes;
+    evict();
+  }
+  size_t capacity() const { return capacity_; }
+
+  void clear() {
+    index_.clear();
+    lru_.clear();
+    stats_.entries = 0;
+    stats_.bytes = 0;
+  }
+
+  Stats stats() const { return stats_; }
+
+private:
+  struct Glyph {
+    int index; // into font.glyphs / font.recs
+    float x;   // pen position relative to the draw position
+  };
+
+  struct Entry {
+    std::string text;
+    uintptr_t font = 0;
+    float size = 0.f;
+    float spacing = 0.f;
+    bool has_extent = false;
+    bool has_glyphs = false;
+    raylib::Vector2 extent{};
+    std::vector<Glyph> glyphs;
+    size_t bytes = 0;
+  };
+
+  struct Key {
+    uintptr_t font;
+    uint32_t size;
+    uint32_t spacing;
+    std::string_view text; // points into Entry::text once stored
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &k) const {
+      size_t h = std::hash<std::string_view>{}(k.text);
+      h ^= (size_t)k.font + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+      h ^= (size_t)((uint64_t)k.size << 32 | k.spacing) + (h << 6) +
+           (h >> 2);
+      return h;
+    }
+  };
+
+  // List and hash nodes plus the entry itself, on top of its heap buffers
+  static constexpr size_t kEntryOverhead = sizeof(Entry) + 64;
+
+  size_t capacity_ = kDefaultCapacityBytes;
+  // Most recently used first
+  std::list<Entry> lru_;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+  Stats stats_;
+
+  static Key key_for(const raylib::Font &font, std::string_view text,
+                     float size, float spacing) {
+    return Key{(uintptr_t)font.glyphs, std::bit_cast<uint32_t>(size),
+               std::bit_cast<uint32_t>(spacing), text};
+  }
+
+  Entry &lookup(const raylib::Font &font, std::string_view text, float size,
+                float spacing);
+  void build_glyphs(const raylib::Font &font, Entry &e);
+  void account(Entry &e);
+  void evict();
+};
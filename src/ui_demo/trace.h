@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ui_demo/dump.h"
+#include "ui_demo/tree_diff.h"
+
+// Records every frame's UI tree as a delta against the previous frame, for
+// --trace=<file>. scripts/ui_trace.js rebuilds the tree at any frame.
+//
+// Append-only binary stream (same primitives as .uitree, see dump.h):
+//   "AHTR" u8 version
+//   then per frame that changed anything:
+//     'F' varint frame, zigzag root_id
+//     'N' zigzag id, name, f32 x y w h     node added
+//     'M' zigzag id, f32 x y w h           rect changed
+//     'C' zigzag id, varint n, n x zigzag  child list changed
+//     'R' zigzag id                        node removed
+//     'E'                                  end of frame
+// Frames with no changes write nothing. A trailing frame without 'E' was cut
+// off mid-write and is ignored by the reader.
+struct UITraceRecorder {
+  static constexpr char kMagic[4] = {'A', 'H', 'T', 'R'};
+  static constexpr uint8_t kVersion = 1;
+
+  std::ofstream out;
+  UITreeSink sink;
+  UITreeNameTable names;
+  UITreeDiff diff;
+  std::vector<afterhours::EntityID> stack;
+  afterhours::EntityID root_id = -1;
+  bool frame_open = false;
+
+  explicit UITraceRecorder(const std::string &path)
+      : out(path, std::ios::binary), sink(out) {
+    sink.put(std::string_view(kMagic, sizeof(kMagic)));
+    sink.put((char)kVersion);
+  }
+
+  ~UITraceRecorder() { sink.flush(); }
+
+  bool ok() const { return out.good(); }
+
+  void put_rect(const UITreeRect &r) {
+    put_f32(sink, r.x);
+    put_f32(sink, r.y);
+    put_f32(sink, r.w);
+    put_f32(sink, r.h);
+  }
+
+  // Writes the frame header the first time this frame has something to say
+  void op(char tag, afterhours::EntityID id) {
+    if (!frame_open) {
+      frame_open = true;
+      sink.put('F');
+      put_varint(sink, diff.frame);
+      put_zigzag(sink, root_id);
+    }
+    sink.put(tag);
+    put_zigzag(sink, id);
+  }
+
+  void put_children(afterhours::EntityID id,
+                    const std::vector<afterhours::EntityID> &children) {
+    op('C', id);
+    put_varint(sink, children.size());
+    for (afterhours::EntityID c : children)
+      put_zigzag(sink, c);
+  }
+
+  // Call once per frame after layout
+  void record_frame() {
+    using namespace afterhours::ui;
+    diff.begin_frame();
+    frame_open = false;
+
+    afterhours::Entity &root_ent = afterhours::EntityQuery()
+                                       .whereHasComponent<AutoLayoutRoot>()
+                                       .gen_first_enforce();
+    root_id = root_ent.id;
+
+    stack.clear();
+    stack.push_back(root_id);
+    while (!stack.empty()) {
+      const afterhours::EntityID id = stack.back();
+      stack.pop_back();
+      auto opt = afterhours::EntityHelper::getEntityForID(id);
+      if (!opt || !opt.asE().has<UIComponent>())
+        continue;
+      afterhours::Entity &e = opt.asE();
+      const UIComponent &cmp = e.get<UIComponent>();
+      const RectangleType r = cmp.rect();
+      const UITreeRect rect{r.x, r.y, r.width, r.height};
+
+      const UITreeDiff::Change change = diff.visit(id, rect, cmp.children);
+      if (change.added) {
+        op('N', id);
+        names.put(sink, e.has<UIComponentDebug>()
+                            ? std::string_view(e.get<UIComponentDebug>().name())
+                            : std::string_view("unknown"));
+        put_rect(rect);
+        if (!cmp.children.empty())
+          put_children(id, cmp.children);
+      } else {
+        if (change.moved) {
+          op('M', id);
+          put_rect(rect);
+        }
+        if (change.children)
+          put_children(id, cmp.children);
+      }
+
+      for (afterhours::EntityID c : cmp.children)
+        stack.push_back(c);
+    }
+
+    diff.end_frame([&](afterhours::EntityID id) { op('R', id); });
+
+    if (frame_open)
+      sink.put('E');
+    sink.maybe_flush();
+  }
+};
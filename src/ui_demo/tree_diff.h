@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ui_demo/dump.h"
+
+// What each UI tree node looked like last frame, for the per-frame diffs of
+// --trace (UITraceRecorder) and --layout-stats (LayoutStats).
+//
+//   diff.begin_frame();
+//   UITreeDiff::Change c = diff.visit(id, rect, children);  once per node
+//   diff.end_frame(on_removed);  calls on_removed(id) for every node that
+//                                was not visited this frame and forgets it
+//
+// Child lists are compared by hash, so a change is only missed on a 64-bit
+// FNV collision.
+struct UITreeDiff {
+  struct Node {
+    UITreeRect rect;
+    uint64_t children_hash = 0;
+    uint64_t seen_frame = 0;
+  };
+
+  struct Change {
+    bool added = false;
+    bool moved = false;    // rect differs from last frame
+    bool children = false; // child list differs from last frame
+  };
+
+  std::unordered_map<afterhours::EntityID, Node> nodes;
+  uint64_t frame = 0;
+  // Scratch for end_frame, reused across frames
+  std::vector<afterhours::EntityID> removed;
+
+  UITreeDiff() { nodes.reserve(1024); }
+
+  void begin_frame() { frame++; }
+
+  Change visit(afterhours::EntityID id, const UITreeRect &rect,
+               const std::vector<afterhours::EntityID> &children) {
+    const uint64_t children_hash = hash_children(children);
+    auto [it, added] = nodes.try_emplace(id);
+    Node &node = it->second;
+    Change c;
+    c.added = added;
+    c.moved = !added && !same_rect(node.rect, rect);
+    c.children = !added && node.children_hash != children_hash;
+    node.rect = rect;
+    node.children_hash = children_hash;
+    node.seen_frame = frame;
+    return c;
+  }
+
+  // Returns how many nodes were removed
+  template <typename OnRemoved> size_t end_frame(OnRemoved &&on_removed) {
+    removed.clear();
+    for (const auto &[id, node] : nodes) {
+      if (node.seen_frame != frame)
+        removed.push_back(id);
+    }
+    for (afterhours::EntityID id : removed) {
+      nodes.erase(id);
+      on_removed(id);
+    }
+    return removed.size();
+  }
+
+  static uint64_t hash_children(const std::vector<afterhours::EntityID> &ids) {
+    uint64_t h = 1469598103934665603ull;
+    for (afterhours::EntityID id : ids) {
+      h ^= (uint64_t)(uint32_t)id;
+      h *= 1099511628211ull;
+    }
+    return h ^ ids.size();
+  }
+
+  static bool same_rect(const UITreeRect &a, const UITreeRect &b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+  }
+};
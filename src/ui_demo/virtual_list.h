@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+// Ensure Raylib-backed types/macros are defined before any afterhours includes
+#include "rl.h"
+
+#include "afterhours/src/plugins/ui/immediate.h"
+#include "ui_demo/intern.h"
+
+// Windowed lists and grids over row counts far past what fits in the entity
+// store.
+//
+// A plain list makes one entity per row with mk(parent, index) and lays all
+// of them out every frame. virtual_list only emits the rows that fit in the
+// list's height and keys each one by its slot, row % rows in view, instead of
+// its index. Scrolling by one row hands the slot of the row that left the top
+// to the row that came in at the bottom, so the same entities are reused with
+// new contents and the entity count and per-frame cost only depend on the
+// list's height, not on `row_count`.
+//
+// The rows in view come from the list's rect in the previous frame's layout,
+// so the list needs a pixel or percent height (not children()), and it is
+// empty on the frame it first appears. Rows scroll in whole steps; the caller
+// owns `first_row`, which is clamped to the last full page.
+namespace ui_demo {
+
+// Rows [first, end) emitted this frame
+struct VirtualRange {
+  size_t first = 0;
+  size_t end = 0;
+};
+
+inline size_t virtual_rows_in_view(afterhours::Entity &list,
+                                   float row_height) {
+  if (row_height <= 0.f)
+    return 0;
+  const float height = list.get<afterhours::ui::UIComponent>().rect().height;
+  return height > 0.f ? (size_t)std::floor(height / row_height) : 0;
+}
+
+// build_row(EntityParent, size_t row) renders one row; it should be
+// `row_height` pixels tall.
+template <typename UIX, typename BuildRow>
+inline VirtualRange
+virtual_list(UIX &context, afterhours::ui::imm::EntityParent ep,
+             size_t row_count, float row_height, size_t &first_row,
+             BuildRow &&build_row,
+             afterhours::ui::ComponentConfig config = {}) {
+  using namespace afterhours::ui;
+  using namespace afterhours::ui::imm;
+
+  afterhours::Entity &list =
+      div(context, ep, config.with_flex_direction(FlexDirection::Column))
+          .ent();
+  const size_t in_view = virtual_rows_in_view(list, row_height);
+  first_row =
+      std::min(first_row, row_count > in_view ? row_count - in_view : 0);
+  const VirtualRange range{first_row,
+                           std::min(row_count, first_row + in_view)};
+  for (size_t row = range.first; row < range.end; row++)
+    build_row(mk(list, (afterhours::EntityID)(row % in_view)), row);
+  return range;
+}
+
+// virtual_list over rows of `columns` cells. `first_row` counts grid rows;
+// build_cell(EntityParent, size_t index) renders cell `index` of `item_count`
+// and should take 1 / columns of the row's width.
+template <typename UIX, typename BuildCell>
+inline VirtualRange
+virtual_grid(UIX &context, afterhours::ui::imm::EntityParent ep,
+             size_t item_count, size_t columns, float row_height,
+             size_t &first_row, BuildCell &&build_cell,
+             afterhours::ui::ComponentConfig config = {}) {
+  using namespace afterhours::ui;
+  using namespace afterhours::ui::imm;
+
+  columns = std::max<size_t>(1, columns);
+  const size_t rows = (item_count + columns - 1) / columns;
+  return virtual_list(
+      context, ep, rows, row_height, first_row,
+      [&](EntityParent row_ep, size_t row) {
+        afterhours::Entity &row_ent =
+            div(context, row_ep,
+                ComponentConfig()
+                    .with_size(ComponentSize{percent(1.f),
+                                             pixels(row_height)})
+                    .with_flex_direction(FlexDirection::Row)
+                    .with_debug_name("virtual_grid_row"_interned))
+                .ent();
+        const size_t first = row * columns;
+        const size_t end = std::min(item_count, first + columns);
+        for (size_t i = first; i < end; i++)
+          build_cell(mk(row_ent, (afterhours::EntityID)(i - first)), i);
+      },
+      std::move(config));
+}
+
+} // namespace ui_demo
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+#include "ui_demo/dump.h"
+
+// Writer for write_ui_tree that only looks at the tree: whether a visible
+// node with a given name exists, and a hash of every node's name, rect and
+// child count so playback can tell when layout has stopped changing. Nodes
+// under a hidden one (a parked subtree, see ui_demo/subtree_retention.h) are
+// hashed but never found.
+struct UITreeProbe {
+  std::string_view want_name;
+  bool found = false;
+  uint64_t hash = 1469598103934665603ull;
+  size_t depth = 0;
+  // Depth of the hidden node being walked, 0 when none
+  size_t hidden_depth = 0;
+
+  void begin() {}
+  void end() {}
+  void begin_node(afterhours::EntityID id, std::string_view name,
+                  const UITreeRect &r, size_t child_count) {
+    depth++;
+    if (hidden_depth == 0 && is_hidden(id))
+      hidden_depth = depth;
+    if (!found && hidden_depth == 0 && !want_name.empty() &&
+        name == want_name)
+      found = true;
+    for (unsigned char c : name)
+      mix(c);
+    mix(std::bit_cast<uint32_t>(r.x));
+    mix(std::bit_cast<uint32_t>(r.y));
+    mix(std::bit_cast<uint32_t>(r.w));
+    mix(std::bit_cast<uint32_t>(r.h));
+    mix(child_count);
+  }
+  void between_children() {}
+  void end_node() {
+    mix(0xff);
+    if (hidden_depth == depth)
+      hidden_depth = 0;
+    depth--;
+  }
+
+  static bool is_hidden(afterhours::EntityID id) {
+    auto opt = afterhours::EntityHelper::getEntityForID(id);
+    if (!opt)
+      return false;
+    afterhours::Entity &e = opt.asE();
+    return e.has<afterhours::ui::UIComponent>() &&
+           e.get<afterhours::ui::UIComponent>().should_hide;
+  }
+
+  void mix(uint64_t v) {
+    hash ^= v;
+    hash *= 1099511628211ull;
+  }
+};
+
+inline UITreeProbe probe_ui_tree(std::string_view want_name) {
+  UITreeProbe probe{.want_name = want_name};
+  write_ui_tree(probe);
+  return probe;
+}
@@ -0,0 +1,198 @@
+// Turns a --log-binary file (see src/log/log_binary.h) back into text, one
+// line per record in the same "file: line: LEVEL: message" shape as vlog.
+//
+//   make log-decode
+//   ./output/log_decode ui.ahlog            all records
+//   ./output/log_decode ui.ahlog --time     prefix [thread +seconds]
+//
+// Records are printed chunk by chunk, i.e. grouped per thread flush rather
+// than globally interleaved by time.
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "log.h"
+
+namespace {
+
+struct Reader {
+  const std::vector<uint8_t> &buf;
+  size_t pos;
+  size_t end;
+
+  bool done() const { return pos >= end; }
+
+  uint8_t u8() {
+    if (pos >= end)
+      throw std::out_of_range("truncated");
+    return buf[pos++];
+  }
+
+  uint64_t varint() {
+    uint64_t v = 0;
+    for (int shift = 0;; shift += 7) {
+      const uint8_t b = u8();
+      v |= (uint64_t)(b & 0x7f) << shift;
+      if ((b & 0x80) == 0)
+        return v;
+    }
+  }
+
+  int64_t zigzag() {
+    const uint64_t v = varint();
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+  }
+
+  template <typename T> T raw() {
+    if (end - pos < sizeof(T))
+      throw std::out_of_range("truncated");
+    T v;
+    std::memcpy(&v, buf.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return v;
+  }
+
+  std::string str() {
+    const uint64_t len = varint();
+    if (end - pos < len)
+      throw std::out_of_range("truncated");
+    std::string s((const char *)buf.data() + pos, len);
+    pos += len;
+    return s;
+  }
+};
+
+struct Site {
+  LogLevel level;
+  uint64_t line;
+  std::string file;
+  std::string format;
+};
+
+std::string format_record(const Site &site, Reader &r) {
+  fmt::dynamic_format_arg_store<fmt::format_context> store;
+  const uint64_t argc = r.varint();
+  for (uint64_t i = 0; i < argc; i++) {
+    switch (r.u8()) {
+    case 'i':
+      store.push_back(r.zigzag());
+      break;
+    case 'u':
+      store.push_back(r.varint());
+      break;
+    case 'd':
+      store.push_back(r.raw<double>());
+      break;
+    case 'b':
+      store.push_back(r.u8() != 0);
+      break;
+    case 'c':
+      store.push_back((char)r.u8());
+      break;
+    case 'p':
+      store.push_back((const void *)(uintptr_t)r.raw<uint64_t>());
+      break;
+    case 's':
+      store.push_back(r.str());
+      break;
+    default:
+      throw std::runtime_error("bad argument tag");
+    }
+  }
+  try {
+    return fmt::vformat(site.format, store);
+  } catch (const fmt::format_error &e) {
+    return fmt::format("<{}> {}", e.what(), site.format);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: log_decode <file.ahlog> [--time]\n");
+    return 2;
+  }
+  const bool with_time = argc > 2 && std::strcmp(argv[2], "--time") == 0;
+
+  std::ifstream in(argv[1], std::ios::binary);
+  if (!in) {
+    std::fprintf(stderr, "failed opening %s\n", argv[1]);
+    return 2;
+  }
+  const std::vector<uint8_t> buf((std::istreambuf_iterator<char>(in)),
+                                 std::istreambuf_iterator<char>());
+  if (buf.size() < 5 || std::memcmp(buf.data(), binary_log::kMagic, 4) != 0) {
+    std::fprintf(stderr, "%s is not a binary log\n", argv[1]);
+    return 1;
+  }
+  if (buf[4] != binary_log::kVersion) {
+    std::fprintf(stderr, "unsupported binary log version %d\n", buf[4]);
+    return 1;
+  }
+
+  std::unordered_map<uint64_t, Site> sites;
+  std::unordered_map<uint64_t, uint64_t> thread_ns;
+  Reader top{buf, 5, buf.size()};
+  try {
+    while (!top.done()) {
+      const uint8_t tag = top.u8();
+      if (tag == 'S') {
+        const uint64_t id = top.varint();
+        Site site;
+        site.level = (LogLevel)top.varint();
+        site.line = top.varint();
+        site.file = top.str();
+        site.format = top.str();
+        sites[id] = std::move(site);
+        continue;
+      }
+      if (tag != 'C')
+        throw std::runtime_error(fmt::format("bad tag '{}'", (char)tag));
+      const uint64_t thread = top.varint();
+      const uint64_t len = top.varint();
+      if (top.end - top.pos < len)
+        throw std::out_of_range("truncated");
+      Reader r{buf, top.pos, top.pos + len};
+      top.pos += len;
+      uint64_t &ns = thread_ns[thread];
+      while (!r.done()) {
+        const uint8_t kind = r.u8();
+        std::string line;
+        if (kind == 'L') {
+          const uint64_t id = r.varint();
+          ns += r.varint();
+          auto it = sites.find(id);
+          if (it == sites.end())
+            throw std::runtime_error(fmt::format("unknown site {}", id));
+          const Site &site = it->second;
+          line = fmt::format("{}: {}: {}: {}", site.file, site.line,
+                             level_to_string(site.level),
+                             format_record(site, r));
+        } else if (kind == 'T') {
+          const LogLevel level = (LogLevel)r.varint();
+          ns += r.varint();
+          line = fmt::format("{}: {}", level_to_string(level), r.str());
+        } else {
+          throw std::runtime_error(fmt::format("bad record '{}'", (char)kind));
+        }
+        if (with_time)
+          fmt::print("[{} +{:.6f}] ", thread, (double)ns / 1e9);
+        fmt::print("{}\n", line);
+      }
+    }
+  } catch (const std::out_of_range &) {
+    // The writer was cut off mid-chunk; everything before it is fine
+    std::fprintf(stderr, "log ends with a truncated record\n");
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "decode error: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}